@@ -0,0 +1,357 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "convex_hull.h"
+#include "divisor_hull.h"
+#include "divisor_piltz.h"
+#include "divisor_sum.h"
+#include "fast_io.h"
+#include "floor_quotient.h"
+#include "hull_file.h"
+#include "modular.h"
+#include "parallel.h"
+
+// Both SPOJ solutions in one binary: each gets a namespace, their main() is
+// left out, and their optimization pragmas stay inside.
+#define SPOJ_NO_MAIN
+#pragma GCC push_options
+namespace divcnt1 {
+#include "spoj_DIVCNT1.cpp"
+}
+#pragma GCC pop_options
+#pragma GCC push_options
+namespace afs3 {
+#include "spoj_AFS3.cpp"
+}
+#pragma GCC pop_options
+
+// Times convex_hull() on the workloads of the test_* functions, called with
+// f and df (as plain lambdas and through std::function, which is how the hull
+// was invoked before it became a template) and with the shape alone (with and
+// without turned), and times S(N) of both SPOJ solutions.
+//
+// Prints one CSV row per run, so that the output of two versions can be
+// compared line by line:
+//   bench,mode,N,threads,repeat,ms,vertices,ns_per_vertex,inside_calls,
+//   slope_calls
+// ms is the average over repeat runs. vertices, inside_calls and slope_calls
+// (calls to df or turned) are counted in one more run that is not timed. For
+// S(N) they are those of the hull S() builds, without the columns it walks
+// one by one.
+//
+// Usage: benchmark [threads] (for S(N), 1 by default, 0 for all cores)
+
+struct counters {
+  long long inside = 0, slope = 0;
+};
+
+// Runs run until min_ms have passed, at least once, and returns the average.
+template <typename Run> double time_ms(const Run &run, int &repeat,
+                                       double min_ms = 200) {
+  std::chrono::duration<double, std::milli> elapsed(0);
+  auto start = std::chrono::steady_clock::now();
+  for (repeat = 0; repeat == 0 || elapsed.count() < min_ms; ++repeat) {
+    run();
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+  return elapsed.count() / repeat;
+}
+
+void report(const char *bench, const char *mode, long long N, int threads,
+            int repeat, double ms, size_t vertices, const counters &count) {
+  printf("%s,%s,%lld,%d,%d,%.3f,%zu,%.1f,%lld,%lld\n", bench, mode, N, threads,
+         repeat, ms, vertices, vertices ? ms * 1e6 / vertices : 0.0,
+         count.inside, count.slope);
+  fflush(stdout);
+}
+
+// One workload in every mode. f, df and inside are the ones of the test,
+// turned is its exact slope comparison, and the hull goes from (x1, y1) to
+// column x2 - 1.
+template <typename F, typename DF, typename Inside, typename Turned>
+void bench_shape(const char *bench, long long N, long long x1, long long y1,
+                 long long x2, hull_shape shape, const F &f, const DF &df,
+                 const Inside &inside, const Turned &turned) {
+  counters count;
+  auto f_counted = [&](long long x) { return f(x); };
+  auto df_counted = [&](long long x) {
+    ++count.slope;
+    return df(x);
+  };
+  auto inside_counted = [&](long long x, long long y) {
+    ++count.inside;
+    return inside(x, y);
+  };
+  auto turned_counted = [&](long long x, long long dx, long long dy) {
+    ++count.slope;
+    return turned(x, dx, dy);
+  };
+  std::function<double(long long)> f_erased = f, df_erased = df;
+  std::function<bool(long long, long long)> inside_erased = inside;
+
+  std::vector<std::pair<long long, long long>> correct_hull, hull;
+  convex_hull(N, x1, y1, x2, f_counted, df_counted, inside_counted,
+              correct_hull);
+  int repeat;
+  double ms = time_ms(
+      [&]() {
+        hull.clear();
+        convex_hull(N, x1, y1, x2, f, df, inside, hull);
+      },
+      repeat);
+  report(bench, "df", N, 1, repeat, ms, correct_hull.size(), count);
+
+  ms = time_ms(
+      [&]() {
+        hull.clear();
+        convex_hull(N, x1, y1, x2, f_erased, df_erased, inside_erased, hull);
+      },
+      repeat);
+  if (hull != correct_hull)
+    fprintf(stderr, "%s %lld: std::function hull mismatch\n", bench, N);
+  report(bench, "df_std_function", N, 1, repeat, ms, correct_hull.size(),
+         count);
+
+  count = counters();
+  hull.clear();
+  convex_hull(x1, y1, x2, shape, inside_counted, turned_counted, hull);
+  if (hull != correct_hull)
+    fprintf(stderr, "%s %lld: turned hull mismatch\n", bench, N);
+  ms = time_ms(
+      [&]() {
+        hull.clear();
+        convex_hull(x1, y1, x2, shape, inside, turned, hull);
+      },
+      repeat);
+  report(bench, "turned", N, 1, repeat, ms, correct_hull.size(), count);
+
+  count = counters();
+  hull.clear();
+  convex_hull(x1, y1, x2, shape, inside_counted, hull);
+  if (hull != correct_hull)
+    fprintf(stderr, "%s %lld: shape-only hull mismatch\n", bench, N);
+  ms = time_ms(
+      [&]() {
+        hull.clear();
+        convex_hull(x1, y1, x2, shape, inside, hull);
+      },
+      repeat);
+  report(bench, "shape_only", N, 1, repeat, ms, correct_hull.size(), count);
+}
+
+long long isqrt(long long N) {
+  long long r = sqrtl(N);
+  while (r * r > N)
+    --r;
+  while ((r + 1) * (r + 1) <= N)
+    ++r;
+  return r;
+}
+
+void bench_concave_decrease(long long N) {
+  // the workload of test_concave_decrease(N): the circle x^2 + y^2 <= N
+  bench_shape(
+      "concave_decrease", N, 1, isqrt(N - 1), isqrt(N), concave_decrease,
+      [&](long long x) { return sqrtl(N - (__int128)x * x); },
+      [&](long long x) { return -x / sqrtl(N - (__int128)x * x); },
+      [&](long long x, long long y) {
+        return y < 0 || (__int128)x * x + (__int128)y * y <= N;
+      },
+      [&](long long x, long long dx, long long dy) {
+        return (__int128)x * x * dx * dx >=
+               (__int128)dy * dy * (N - (__int128)x * x);
+      });
+}
+
+void bench_concave_increase(long long N) {
+  // the workload of test_concave_increase(N), centred on an integer
+  const long long c = isqrt(N);
+  bench_shape(
+      "concave_increase", N, 1, isqrt(N - (c - 1) * (c - 1)), c,
+      concave_increase,
+      [&](long long x) { return sqrtl(N - (__int128)(c - x) * (c - x)); },
+      [&](long long x) {
+        return (c - x) / sqrtl(N - (__int128)(c - x) * (c - x));
+      },
+      [&](long long x, long long y) {
+        return y < 0 || (__int128)(c - x) * (c - x) + (__int128)y * y <= N;
+      },
+      [&](long long x, long long dx, long long dy) {
+        return (__int128)(c - x) * (c - x) * dx * dx <=
+               (__int128)dy * dy * (N - (__int128)(c - x) * (c - x));
+      });
+}
+
+void bench_convex_decrease(long long N) {
+  // the workload of test_convex_decrease(N, false): xy > N
+  bench_shape(
+      "convex_decrease", N, 1, N + 1, N + 1, convex_decrease,
+      [&](long long x) { return N * 1.0 / x; },
+      [&](long long x) { return -N * 1.0 / x / x; },
+      [&](long long x, long long y) { return (__int128)x * y > N; },
+      [&](long long x, long long dx, long long dy) {
+        return (__int128)N * dx <= (__int128)x * x * dy;
+      });
+}
+
+void bench_convex_increase(long long N) {
+  // the workload of test_convex_increase(N, false): (N + 1 - x) y > N
+  bench_shape(
+      "convex_increase", N, 1, 2, N + 1, convex_increase,
+      [&](long long x) { return N * 1.0 / (N + 1 - x); },
+      [&](long long x) { return N * 1.0 / (N + 1 - x) / (N + 1 - x); },
+      [&](long long x, long long y) { return (__int128)(N + 1 - x) * y > N; },
+      [&](long long x, long long dx, long long dy) {
+        return (__int128)N * dx >= (__int128)(N + 1 - x) * (N + 1 - x) * dy;
+      });
+}
+
+// Counts the hull of xy > N over from <= x < to that divisor_hull_range()
+// builds, adding to count and vertices.
+void count_hull(long long N, long long from, long long to, counters &count,
+                size_t &vertices) {
+  auto outside = [&](long long x, long long y) {
+    ++count.inside;
+    return (__int128)x * y > (__int128)N;
+  };
+  auto turned = [&](long long x, long long dx, long long dy) {
+    ++count.slope;
+    return (__int128)N * dx <= (__int128)x * x * dy;
+  };
+  convex_hull(from, N / from + 1, to, convex_decrease, outside, turned,
+              [&](long long, long long) { ++vertices; });
+}
+
+// Counts the hull S() builds, with the arguments it passes.
+counters S_hull(long long N, size_t &vertices) {
+  counters count;
+  vertices = 0;
+  count_hull(N, divisor_hull_x0(N) + 1, divisor_hull_x1(N), count, vertices);
+  return count;
+}
+
+// Counts the hulls divisor_count_3() builds: one of m = N / a for each least
+// factor a, over the rows divisor_band_columns() takes beyond column X.
+counters piltz_hulls(long long N, size_t &vertices) {
+  counters count;
+  vertices = 0;
+  for (long long a = 1, r = divisor_hull_cbrt(N); a <= r; ++a) {
+    const long long m = N / a, s = divisor_hull_x0(m),
+                    X = std::max(a, std::min(s, 32 * (long long)cbrtl(m)));
+    if (X >= s)
+      continue;
+    const long long low = m / s, Y = m / (X + 1);
+    if (Y > low)
+      count_hull(m, low + 1, Y + 1, count, vertices);
+  }
+  return count;
+}
+
+// S(N) timed, with the counters of the hulls it builds as hulls() reports
+// them.
+template <typename Solve>
+void bench_S(const char *bench, long long N, int threads, const Solve &S,
+             counters (*hulls)(long long, size_t &) = S_hull) {
+  size_t vertices;
+  counters count = hulls(N, vertices);
+  volatile __int128 sink;
+  int repeat;
+  double ms = time_ms([&]() { sink = S(N, threads); }, repeat);
+  (void)sink;
+  report(bench, "S", N, threads, repeat, ms, vertices, count);
+}
+
+// S(N) on one thread, summed over its hull read back from a hull file
+// (hull_file.h) instead of built, which calls neither inside nor turned.
+template <typename Solve>
+void bench_S_file(const char *bench, long long N, const Solve &S) {
+  hull_encoder encoder(N);
+  divisor_hull(N, encoder);
+  char path[] = "/tmp/hull_file_XXXXXX";
+  const int fd = mkstemp(path);
+  if (fd < 0 || !encoder.save(path)) {
+    fprintf(stderr, "%s %lld: cannot write %s\n", bench, N, path);
+    return;
+  }
+  close(fd);
+  const hull_view view(path);
+  unlink(path);
+  volatile __int128 sink;
+  int repeat;
+  double ms = time_ms([&]() { sink = S(N, &view); }, repeat);
+  (void)sink;
+  report(bench, "S_hull_file", N, 1, repeat, ms, view.size(), counters());
+}
+
+int main(int argc, char **argv) {
+  const int threads = argc > 1 ? atoi(argv[1]) : 1;
+  printf("bench,mode,N,threads,repeat,ms,vertices,ns_per_vertex,"
+         "inside_calls,slope_calls\n");
+
+  for (long long N : {1000000000LL, 1000000000000LL, 100000000000000LL})
+    bench_concave_decrease(N);
+  // with f and df, the hull of this shape takes about N^0.7 calls
+  for (long long N : {100000000LL, 1000000000LL, 10000000000LL})
+    bench_concave_increase(N);
+  for (long long N : {1000000LL, 10000000LL, 100000000LL})
+    bench_convex_decrease(N);
+  for (long long N : {1000000LL, 10000000LL, 100000000LL})
+    bench_convex_increase(N);
+
+  for (long long N :
+       {1000000000LL, 1000000000000LL, 1000000000000000LL,
+        1000000000000000000LL, 9200000000000000000LL})
+    bench_S("DIVCNT1", N, threads, [](long long n, int threads) {
+      return divcnt1::S(n, threads);
+    });
+  // the same hulls in __int128 coordinates, which N beyond 2^63 needs
+  for (long long N : {1000000000000LL, 1000000000000000LL,
+                      1000000000000000000LL})
+    bench_S("DIVCNT1_int128", N, threads, [](long long n, int threads) {
+      return divcnt1::S<__int128, __int128>(n, threads);
+    });
+  for (long long N :
+       {1000000000LL, 1000000000000LL, 1000000000000000LL,
+        1000000000000000000LL, 9200000000000000000LL})
+    bench_S("AFS3", N, threads, [](long long n, int threads) {
+      return afs3::S(n, threads);
+    });
+  // sigma_0 and sigma_1 (sigma_2 too, modulo a prime) from one hull
+  for (long long N :
+       {1000000000LL, 1000000000000LL, 1000000000000000LL,
+        1000000000000000000LL})
+    bench_S("divisor_sum_1", N, threads, [](long long n, int threads) {
+      return divisor_sum<1>(n, threads).sigma[1];
+    });
+  for (long long N :
+       {1000000000LL, 1000000000000LL, 1000000000000000LL,
+        1000000000000000000LL})
+    bench_S("divisor_sum_2_mod", N, threads, [](long long n, int threads) {
+      return (__int128)divisor_sum<2, modular<998244353>>(n, threads)
+          .sigma[2]
+          .v;
+    });
+  // D_3(N), one hull of N / a for every least factor a
+  for (long long N : {1000000000LL, 1000000000000LL, 100000000000000LL})
+    bench_S(
+        "divisor_count_3", N, threads,
+        [](long long n, int threads) { return divisor_count_3(n, threads); },
+        piltz_hulls);
+  for (long long N : {1000000000000000LL, 1000000000000000000LL}) {
+    bench_S_file("DIVCNT1", N, [](long long n, const hull_view *hull) {
+      return divcnt1::S(n, 1, hull);
+    });
+    bench_S_file("AFS3", N, [](long long n, const hull_view *hull) {
+      return afs3::S(n, 1, hull);
+    });
+  }
+  return 0;
+}
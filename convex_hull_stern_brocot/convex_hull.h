@@ -0,0 +1,647 @@
+#ifndef CONVEX_HULL_H
+#define CONVEX_HULL_H
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "hull_stats.h"
+#include "parallel.h"
+
+// Coordinates are long long unless the shape-tagged entry points below get
+// another signed integer type I as their first template argument, e.g.
+// convex_hull<__int128>(...) for hulls beyond 2^63. Directions and run
+// lengths share that type; hull_coordinate keeps it from being deduced, so
+// that calls mixing int and long long arguments still pick long long.
+// Unsigned types are refused: the backtrack and the limits of a run take
+// differences of coordinates that may be negative, and hull_max() assumes a
+// sign bit. Hulls in [0, 2^64) go through __int128 instead.
+template <typename I> struct hull_coordinate {
+  static_assert(I(-1) < I(0), "hull coordinates must be signed");
+  typedef I type;
+};
+
+// the largest value of I, also where std::numeric_limits does not know I
+template <typename I> constexpr I hull_max() {
+  return ((I(1) << (sizeof(I) * 8 - 2)) - 1) * 2 + 1;
+}
+
+// gcd(a, b) for a, b >= 0, also where std::gcd refuses I, as for __int128
+template <typename I> I hull_gcd(I a, I b) {
+  while (b) {
+    I t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// The vertices of the hull are handed out in order of x, either appended to
+// a vector or passed to a callable visit(x, y). Two consecutive calls of the
+// visitor are the ends of one edge, so callers summing over the edges need
+// not keep the hull in memory.
+template <typename I>
+void emit_vertex(std::vector<std::pair<I, I>> &ret, const I &x, const I &y) {
+  ret.emplace_back(x, y);
+}
+
+template <typename Visit, typename I>
+void emit_vertex(Visit &visit, const I &x, const I &y) {
+  visit(x, y);
+}
+
+// A run of directions on the stack of the descent: base + j * step for
+// j = 0, ..., count, the last one on top. A long run of mediants takes one
+// entry, so that the stack stays as deep as the number of runs.
+template <typename I> struct hull_run {
+  std::pair<I, I> base, step;
+  I count;
+
+  std::pair<I, I> at(const I &j) const {
+    return std::make_pair(base.first + j * step.first,
+                          base.second + j * step.second);
+  }
+  std::pair<I, I> top() const { return at(count); }
+};
+
+// Scratch memory of the hull engine. Callers building many hulls keep one and
+// pass it to every call; once it has grown to the size of their hulls,
+// building another one allocates nothing (apart from the threads of
+// convex_hull_parallel()). Without one, each call starts from an empty
+// workspace. A workspace serves one hull at a time, so code that may run in
+// several threads keeps a static thread_local one, warm from call to call.
+template <typename I> struct basic_hull_workspace {
+  std::vector<hull_run<I>> stack; // directions to try
+  // for convex_hull_parallel(): the first column and its extreme point, the
+  // workspace, the sub-hull and the first slope of each chunk, and the
+  // stitched hull
+  std::vector<I> from, start;
+  std::vector<basic_hull_workspace> chunks;
+  std::vector<std::vector<std::pair<I, I>>> parts;
+  std::vector<std::pair<I, I>> first_slopes, hull;
+
+  basic_hull_workspace() = default;
+  basic_hull_workspace(const I &N, const size_t &vertices) {
+    reserve(N, vertices);
+  }
+
+  // Room for a hull of about vertices vertices under a curve up to N high.
+  // The stack of N / x goes about 6 sqrt(vertices) runs deep (13099 for
+  // N = 1e18), and never needs less than 2 log2(N).
+  void reserve(const I &N, const size_t &vertices) {
+    size_t bits = 0;
+    for (I n = N | 1; n; n >>= 1)
+      ++bits;
+    stack.reserve(2 * bits + (size_t)(6 * sqrt((double)vertices)));
+    hull.reserve(vertices);
+  }
+};
+typedef basic_hull_workspace<long long> hull_workspace;
+
+// The last j such that holds(j), given holds(0), where holds is true up to
+// some j and false beyond as long as j <= cap: exponential, then binary
+// search, in O(log j) calls. Past cap it goes on one j at a time. holds() is
+// called from one place only, so that it is inlined once.
+template <typename I, typename Holds>
+I gallop(const I &cap, const Holds &holds) {
+  // holds(lo), and !holds(hi) once hi > 0
+  I lo = 0, hi = 0, step = 1;
+  while (!hi || hi - lo > 1) {
+    I j = lo + 1;
+    if (hi)
+      j = lo + (hi - lo) / 2;
+    else if (lo < cap) {
+      j = lo + std::min(step, cap - lo);
+      if (step < hull_max<I>() / 2)
+        step *= 2;
+    }
+    if (holds(j))
+      lo = j;
+    else
+      hi = j;
+  }
+  return lo;
+}
+
+enum hull_shape {
+  concave_decrease,
+  concave_increase,
+  convex_decrease,
+  convex_increase
+};
+
+// Stern-Brocot walk along the hull shared by all entry points below, compiled
+// once per shape so that the shape costs no branch in the loops.
+// flat(x1, y) tells whether the hull starts with the horizontal slope 1/0
+// (y is y1 raised onto the region for convex functions).
+// cut(x, y, left, right, run) is asked when the mediant (x, y) fails the
+// predicate and returns true when no mediant between left and right can pass
+// it, which ends the descent. run counts the mediants that failed in a row.
+// monotone_cut tells that along such a run cut stays true once it is, as when
+// it compares slopes; the runs of failing mediants are galloped then, and
+// walked one by one otherwise.
+//
+// The four shapes are reflections of each other. The slope of the next edge
+// lies between left and right; a mediant passing inside replaces the bound
+// on the side of the vertical where f decreases (right) and of the
+// horizontal where it increases (left), and one failing replaces the other.
+// The stack holds the directions still to try, on top of 0/1 where the hull
+// gets steeper (concave_decrease, convex_increase) and of 1/0 where it
+// flattens, a run of mediants per entry (hull_run).
+template <hull_shape Shape, typename I, typename Inside, typename Flat,
+          typename Cut, typename Out>
+std::pair<I, I> convex_hull_kernel(const I &x1, const I &y1, const I &x2,
+                                   const Inside &inside, const Flat &flat,
+                                   const Cut &cut, const bool &monotone_cut,
+                                   Out &ret,
+                                   std::vector<hull_run<I>> &stac) {
+  constexpr bool convex = Shape == convex_decrease || Shape == convex_increase;
+  constexpr int sign =
+      (Shape == concave_decrease || Shape == convex_decrease) ? -1 : 1;
+  constexpr bool steepening =
+      Shape == concave_decrease || Shape == convex_increase;
+  const std::pair<I, I> horizontal(1, 0), vertical(0, 1);
+
+  HULL_STAT(hull_stats stats);
+  if (inside(x1, y1)) {
+    emit_vertex(ret, x1, y1);
+    HULL_STAT(stats.emitted(ret));
+  }
+  if (x1 + 1 == x2)
+    return std::make_pair(0, 0);
+
+  I x = x1, y = y1;
+  if (convex) {
+    const auto &outside = inside;
+    while (!outside(x, y)) {
+      HULL_STAT(++stats.s[stat_start]);
+      ++y;
+    }
+  }
+
+  stac.clear();
+  auto push = [&](const std::pair<I, I> &d) {
+    stac.push_back(hull_run<I>{d, std::pair<I, I>(0, 0), 0});
+    HULL_STAT(stats.depth(stac.size()));
+  };
+  auto pop = [&]() {
+    if (stac.back().count)
+      --stac.back().count;
+    else
+      stac.pop_back();
+  };
+  std::pair<I, I> left, right;
+  // the bound moved by a passing mediant and the one moved by a failing one
+  std::pair<I, I> &pass = sign == -1 ? right : left;
+  std::pair<I, I> &fail = sign == -1 ? left : right;
+  // Mediants come in runs along a line: pass + j * fail while they pass,
+  // fail + j * pass while they fail, and so do the steps along an edge. The
+  // line meets the convex region in an interval, so once a run is long, its
+  // end is found by galloping over j. Where the line leaves the region f has
+  // turned past it, so with monotone_cut a failing run gallops as well.
+  constexpr int short_run = 4;
+  // how far a run may gallop: while y stays >= 0 where f decreases, as
+  // inside need not describe a convex region below the x-axis, and without
+  // overflowing y where f increases
+  auto reach = [&](const std::pair<I, I> &base,
+                   const std::pair<I, I> &d) -> I {
+    if (!d.second)
+      return hull_max<I>() - 1;
+    if (sign == -1)
+      return std::max(I(0), (y - base.second) / d.second);
+    return (hull_max<I>() - 1 - y - base.second) / d.second;
+  };
+  auto descend = [&]() {
+    I run = 0;
+    for (int passed = 0;;) {
+      HULL_STAT(++stats.s[stat_descent]);
+      std::pair<I, I> mid = std::make_pair(
+          left.first + right.first, left.second + right.second);
+      if (x + mid.first < x2 && inside(x + mid.first, y + sign * mid.second)) {
+        pass = mid;
+        push(mid);
+        run = 0;
+        if (++passed < short_run)
+          continue;
+        passed = 0;
+        const I k = gallop(reach(pass, fail), [&](const I &j) {
+          const I mx = x + pass.first + j * fail.first;
+          HULL_STAT(++stats.s[stat_descent]);
+          return mx < x2 &&
+                 inside(mx, y + sign * (pass.second + j * fail.second));
+        });
+        stac.back().step = fail;
+        stac.back().count = k;
+        pass = stac.back().top();
+      } else {
+        if (x + mid.first >= x2)
+          break;
+        HULL_STAT(++stats.s[stat_cut]);
+        if (cut(x + mid.first, y + sign * mid.second, left, right, ++run))
+          break;
+        fail = mid;
+        passed = 0;
+        if (!monotone_cut || run < short_run)
+          continue;
+        // cut only looks at the bound moved by passing mediants
+        const I k = gallop(reach(fail, pass), [&](const I &j) {
+          const I mx = x + fail.first + j * pass.first,
+                          my = y + sign * (fail.second + j * pass.second);
+          HULL_STAT(++stats.s[stat_descent]);
+          if (mx >= x2 || inside(mx, my))
+            return false;
+          HULL_STAT(++stats.s[stat_cut]);
+          return !cut(mx, my, left, right, run + j);
+        });
+        fail = std::make_pair(fail.first + k * pass.first,
+                              fail.second + k * pass.second);
+        run += k;
+      }
+    }
+  };
+
+  std::pair<I, I> first_slope;
+  push(steepening ? vertical : horizontal);
+  if (flat(x1, y)) {
+    first_slope = horizontal;
+    if (steepening)
+      push(horizontal);
+  } else {
+    pass = stac.back().top();
+    fail = steepening ? horizontal : vertical;
+    descend();
+    first_slope = stac.back().top();
+  }
+  while (true) {
+    pass = stac.back().top();
+    if (!pass.first)
+      break;
+    pop();
+    // the edge is a run along pass as well, galloped once it is long
+    int steps = 0;
+    while (x + pass.first < x2 &&
+           inside(x + pass.first, y + sign * pass.second)) {
+      HULL_STAT(++stats.s[stat_walk]);
+      x += pass.first;
+      y += sign * pass.second;
+      if (++steps < short_run)
+        continue;
+      const I k = gallop(
+          reach(std::pair<I, I>(0, 0), pass), [&](const I &j) {
+            const I mx = x + j * pass.first;
+            HULL_STAT(++stats.s[stat_walk]);
+            return mx < x2 && inside(mx, y + sign * j * pass.second);
+          });
+      x += k * pass.first;
+      y += sign * k * pass.second;
+      break;
+    }
+    const bool moved = steps > 0;
+    if (moved && y >= 0) {
+      emit_vertex(ret, x, y);
+      HULL_STAT(stats.emitted(ret));
+    }
+    // Backtrack to the last direction passing inside before x2. Along a run
+    // the directions lie on a line, of which the region holds an interval;
+    // the run was pushed from an earlier vertex on the same side of it, so
+    // the directions passing form a prefix of the run, and its failing end is
+    // galloped off.
+    fail = pass;
+    while (!stac.empty()) {
+      hull_run<I> &top = stac.back();
+      pass = top.top();
+      if (x + pass.first < x2 && inside(x + pass.first, y + sign * pass.second))
+        break;
+      const I k = gallop(top.count, [&](const I &i) {
+        if (i == 0)
+          return true;
+        if (i > top.count)
+          return false;
+        const std::pair<I, I> d = top.at(top.count - i);
+        HULL_STAT(++stats.s[stat_backtrack]);
+        return x + d.first >= x2 || !inside(x + d.first, y + sign * d.second);
+      });
+      HULL_STAT(++stats.s[stat_backtrack]);
+      fail = top.at(top.count - k);
+      if (k == top.count) {
+        stac.pop_back();
+        continue;
+      }
+      top.count -= k + 1;
+      pass = top.top();
+      break;
+    }
+    if (stac.empty())
+      break;
+    descend();
+  }
+  return first_slope;
+}
+
+// Picks the instantiation of convex_hull_kernel() for shape, and the stack
+// of work or a fresh one.
+template <typename I, typename Inside, typename Flat, typename Cut,
+          typename Out>
+std::pair<I, I>
+convex_hull_descent(const I &x1, const I &y1, const I &x2,
+                    const hull_shape &shape, const Inside &inside,
+                    const Flat &flat, const Cut &cut, const bool &monotone_cut,
+                    Out &ret, basic_hull_workspace<I> *work) {
+  std::vector<hull_run<I>> local;
+  std::vector<hull_run<I>> &stac = work ? work->stack : local;
+  switch (shape) {
+  case concave_decrease:
+    return convex_hull_kernel<concave_decrease>(x1, y1, x2, inside, flat, cut,
+                                                monotone_cut, ret, stac);
+  case concave_increase:
+    return convex_hull_kernel<concave_increase>(x1, y1, x2, inside, flat, cut,
+                                                monotone_cut, ret, stac);
+  case convex_decrease:
+    return convex_hull_kernel<convex_decrease>(x1, y1, x2, inside, flat, cut,
+                                               monotone_cut, ret, stac);
+  default:
+    return convex_hull_kernel<convex_increase>(x1, y1, x2, inside, flat, cut,
+                                               monotone_cut, ret, stac);
+  }
+}
+
+// Whether the hull over [x, x2) starts with the horizontal slope 1/0 (y is
+// the extreme point of column x). Where the extreme points move away from
+// the region (decreasing concave, increasing convex) this is decided by
+// column x + 1 alone. Otherwise no later column may go beyond y, and the last
+// one goes furthest: checking column x + 1 there would take a start like
+// (3, 7) under the circle of radius 10 around (10, 0) for flat, although
+// (6, 9) lies above it.
+template <typename I, typename Inside>
+bool hull_starts_flat(const hull_shape &shape, const Inside &inside,
+                      const I &x, const I &y, const I &x2) {
+  switch (shape) {
+  case concave_decrease:
+    return inside(x + 1, y);
+  case concave_increase:
+    return !inside(x2 - 1, y + 1);
+  case convex_decrease:
+    return !inside(x2 - 1, y - 1);
+  default:
+    return inside(x + 1, y);
+  }
+}
+
+template <typename F, typename DF, typename Inside, typename Out>
+std::pair<long long, long long>
+convex_hull(const long long & /* N */, const long long &x1,
+            const long long &y1, const long long &x2, const F & /* f */,
+            const DF &df, const Inside &inside, Out &&ret,
+            hull_workspace *work = nullptr) {
+  // x1: from (inclusive)  x2: to (exclusive)
+  // Note that for concave function, the inside function means the points on f
+  // should be included
+  // but for convex function, the inside function means the outside
+  // return:
+  //   ret: the vertices of the convex hull under the function f, either a
+  //        vector to append them to or a callable visit(x, y) receiving them
+  //        one by one (see emit_vertex)
+  //   work: scratch memory to reuse across calls (see hull_workspace)
+  //   return value: the slope of the convex hull (x,y) at x1
+
+  // Assumptions:
+  // f(x) is positive on x1<=x<x2
+  // df(x) is monotonic
+  // df(x) has the same sign on x1<=x<x2
+  // (x1, y1) should be on the convex hull (I don't check it)
+
+  // f, df and inside are template parameters rather than std::function so
+  // that the predicate is inlined into the Stern-Brocot descent.
+
+  assert(x1 < x2);
+  const bool convex = df(x1) < df(x1 + 1);
+  const int sign = (df(x1) < 0) ? -1 : 1;
+  auto cut = [&](long long x, long long,
+                 const std::pair<long long, long long> &left,
+                 const std::pair<long long, long long> &right,
+                 const long long &) -> bool {
+    // as turned() below: d passes inside, and the hull gets steeper where f
+    // is concave and decreasing or convex and increasing
+    const std::pair<long long, long long> &d = sign == -1 ? right : left;
+    if (convex == (sign == 1))
+      return sign * df(x) * d.first >= d.second;
+    return sign * df(x) * d.first <= d.second;
+  };
+  const hull_shape shape =
+      convex ? (sign == -1 ? convex_decrease : convex_increase)
+             : (sign == -1 ? concave_decrease : concave_increase);
+  auto flat = [&](const long long &x, const long long &y) -> bool {
+    return hull_starts_flat(shape, inside, x, y, x2);
+  };
+  return convex_hull_descent(x1, y1, x2, shape, inside, flat, cut, true, ret,
+                             work);
+}
+
+// The extreme point of column x passing inside, i.e. the highest one for
+// concave shapes and the lowest one for convex shapes, searched by galloping
+// from the guess y.
+template <typename I, typename Inside>
+I column_extreme(const hull_shape &shape, const Inside &inside, const I &x,
+                 const I &y) {
+  // direction along the column towards the points passing inside
+  const int toward = (shape == convex_decrease || shape == convex_increase)
+                         ? 1
+                         : -1;
+  const bool passes = inside(x, y);
+  // inside(x, y + step * lo) == passes != inside(x, y + step * hi)
+  const int step = passes ? -toward : toward;
+  I lo = 0, hi = 1;
+  while (inside(x, y + step * hi) == passes) {
+    lo = hi;
+    hi *= 2;
+  }
+  while (hi - lo > 1) {
+    I mid = (lo + hi) / 2;
+    if (inside(x, y + step * mid) == passes)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return passes ? y + step * lo : y + step * hi;
+}
+
+// Shape-tagged entry points: neither f nor df is needed, so no floating point
+// is involved and the hull stays exact beyond 2^53.
+//
+// Assumptions (besides the ones of the entry point above):
+// inside is exact and monotonic along each column, i.e. every point below
+// (concave) or above (convex) a point passing inside passes it as well
+//
+// turned(x, dx, dy) tells whether the tangent of f at x has already turned
+// past the direction (dx, dy) the way the hull turns, i.e.
+// |f'(x)| * dx >= dy where f gets steeper (concave_decrease, convex_increase)
+// and |f'(x)| * dx <= dy where f flattens (concave_increase, convex_decrease).
+// It is usually a cheap integer comparison, e.g. N * dx <= x * x * dy for
+// f(x) = N / x.
+template <typename I = long long, typename Inside, typename Turned,
+          typename Out>
+std::pair<I, I> convex_hull(const typename hull_coordinate<I>::type &x1,
+                            const typename hull_coordinate<I>::type &y1,
+                            const typename hull_coordinate<I>::type &x2,
+                            const hull_shape &shape, const Inside &inside,
+                            const Turned &turned, Out &&ret,
+                            basic_hull_workspace<I> *work = nullptr) {
+  assert(x1 < x2);
+  const int sign =
+      (shape == concave_decrease || shape == convex_decrease) ? -1 : 1;
+  auto flat = [&](const I &x, const I &y) -> bool {
+    return hull_starts_flat(shape, inside, x, y, x2);
+  };
+  auto cut = [&](const I &x, const I &, const std::pair<I, I> &left,
+                 const std::pair<I, I> &right, const I &) -> bool {
+    // the mediants still to come are beyond (x, y) along the direction that
+    // passes inside: right if decreasing, left if increasing
+    const std::pair<I, I> &d = sign == -1 ? right : left;
+    return turned(x, d.first, d.second);
+  };
+  return convex_hull_descent(x1, y1, x2, shape, inside, flat, cut, true, ret,
+                             work);
+}
+
+// Without turned the descent is decided by inside alone. This is exact as
+// well but needs more probes where f is nearly straight: the end of a run of
+// failing mediants can only be certified once the curvature shows up on the
+// lattice.
+template <typename I = long long, typename Inside, typename Out>
+std::pair<I, I> convex_hull(const typename hull_coordinate<I>::type &x1,
+                            const typename hull_coordinate<I>::type &y1,
+                            const typename hull_coordinate<I>::type &x2,
+                            const hull_shape &shape, const Inside &inside,
+                            Out &&ret,
+                            basic_hull_workspace<I> *work = nullptr) {
+  assert(x1 < x2);
+  const bool convex = shape == convex_decrease || shape == convex_increase;
+  const int sign =
+      (shape == concave_decrease || shape == convex_decrease) ? -1 : 1;
+  // direction along a column towards the points passing inside
+  const int toward = convex ? 1 : -1;
+  auto flat = [&](const I &x, const I &y) -> bool {
+    return hull_starts_flat(shape, inside, x, y, x2);
+  };
+  // Let d be the direction that passes inside. The failing mediants of a run
+  // lie on one line of direction d, which starts at the point base =
+  // (x, y) - run * d failing as well. Let base + offset be the first point of
+  // its column passing inside. If (x, y) + offset fails, the chord of f from
+  // the column of base to x has turned past d, and by convexity the line
+  // never reaches the region again. No mediant between left and right can
+  // pass then, since each of them would put a point of that line inside.
+  I offset = 0;
+  auto cut = [&](const I &x, const I &y, const std::pair<I, I> &left,
+                 const std::pair<I, I> &right, const I &run) -> bool {
+    const std::pair<I, I> &d = sign == -1 ? right : left;
+    if (x + d.first >= x2)
+      return true;
+    if (run == 1) {
+      const I bx = x - d.first, by = y - sign * d.second;
+      offset = toward * (column_extreme(shape, inside, bx, by) - by);
+    }
+    return !inside(x, y + toward * offset);
+  };
+  return convex_hull_descent(x1, y1, x2, shape, inside, flat, cut, false, ret,
+                             work);
+}
+
+// The hull of the shape-tagged convex_hull() with turned, built on up to
+// threads threads (threads <= 0 takes all of them).
+//
+// [x1, x2) is cut into chunks whose widths grow geometrically, as hulls like
+// the one of N / x thin out with growing x. Each chunk starts from the
+// extreme point of its first column, found with column_extreme(), and its
+// sub-hull is built independently. Every vertex of the whole hull is a
+// vertex of the sub-hull of its chunk, so a monotone chain over the sub-hulls
+// in order, dropping the points where the hull does not turn strictly, yields
+// exactly the serial hull. The sub-hulls are kept until they are stitched;
+// the result then goes to ret in order.
+//
+// chunks <= 0 picks 4 chunks per thread, but none narrower than 2^16
+// columns, so that small ranges and a single thread stay serial. work keeps
+// the chunks, their sub-hulls and their workspaces for the next call.
+template <typename I = long long, typename Inside, typename Turned,
+          typename Out>
+std::pair<I, I>
+convex_hull_parallel(const typename hull_coordinate<I>::type &x1,
+                     const typename hull_coordinate<I>::type &y1,
+                     const typename hull_coordinate<I>::type &x2,
+                     const hull_shape &shape, const Inside &inside,
+                     const Turned &turned, Out &&ret, int threads = 0,
+                     long long chunks = 0,
+                     basic_hull_workspace<I> *work = nullptr) {
+  assert(x1 < x2);
+  if (threads <= 0)
+    threads = hardware_threads();
+  if (chunks <= 0)
+    chunks = threads > 1 ? (long long)std::min<I>(4 * threads, (x2 - x1) >> 16)
+                         : 1;
+  chunks = (long long)std::min<I>(chunks, x2 - x1);
+  if (chunks <= 1)
+    return convex_hull<I>(x1, y1, x2, shape, inside, turned, ret, work);
+
+  basic_hull_workspace<I> local;
+  basic_hull_workspace<I> &w = work ? *work : local;
+  std::vector<I> &from = w.from, &start = w.start;
+  from.resize(chunks + 1), start.resize(chunks);
+  const double base = (double)std::max<I>(x1, 1), ratio = (double)x2 / base;
+  from[0] = x1;
+  from[chunks] = x2;
+  start[0] = y1;
+  for (long long k = 1; k < chunks; ++k) {
+    I x = base * pow(ratio, (double)k / chunks);
+    from[k] = std::min(std::max(x, from[k - 1] + 1), x2 - (chunks - k));
+    start[k] = column_extreme(shape, inside, from[k], start[k - 1]);
+  }
+
+  std::vector<std::vector<std::pair<I, I>>> &parts = w.parts;
+  std::vector<std::pair<I, I>> &first_slopes = w.first_slopes;
+  if (w.chunks.size() < (size_t)chunks)
+    w.chunks.resize(chunks);
+  if (parts.size() < (size_t)chunks)
+    parts.resize(chunks);
+  first_slopes.resize(chunks);
+  parallel_for(chunks, threads, [&](long long k) {
+    parts[k].clear();
+    first_slopes[k] = convex_hull<I>(from[k], start[k], from[k + 1], shape,
+                                     inside, turned, parts[k], &w.chunks[k]);
+  });
+
+  const bool convex = shape == convex_decrease || shape == convex_increase;
+  // whether a -> b -> c turns the way the hull does: counterclockwise below
+  // a convex function, clockwise below a concave one
+  auto turns = [&](const std::pair<I, I> &a, const std::pair<I, I> &b,
+                   const std::pair<I, I> &c) {
+    __int128 cross = (__int128)(b.first - a.first) * (c.second - b.second) -
+                     (__int128)(b.second - a.second) * (c.first - b.first);
+    return convex ? cross > 0 : cross < 0;
+  };
+  std::vector<std::pair<I, I>> &hull = w.hull;
+  hull.clear();
+  for (long long k = 0; k < chunks; ++k)
+    for (const auto &p : parts[k]) {
+      while (hull.size() >= 2 && !turns(hull[hull.size() - 2], hull.back(), p))
+        hull.pop_back();
+      hull.push_back(p);
+    }
+  HULL_STAT(hull_stats stats;
+            stats.s[stat_ret_bytes] = hull.capacity() * sizeof(hull[0]));
+  for (const auto &p : hull)
+    emit_vertex(ret, p.first, p.second);
+
+  // The first chunk knows the first slope unless its first edge was replaced
+  // by one reaching into a later chunk.
+  if (hull.size() < 2 || (parts[0].size() >= 2 && parts[0][1] == hull[1]))
+    return first_slopes[0];
+  I dx = hull[1].first - hull[0].first, dy = hull[1].second - hull[0].second;
+  if (dy < 0)
+    dy = -dy;
+  const I g = hull_gcd(dx, dy);
+  return std::make_pair(dx / g, dy / g);
+}
+
+#endif
@@ -1,521 +1,270 @@
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
+#include <new>
+#include <random>
 #include <utility>
 #include <vector>
 
+#include "convex_hull.h"
+#include "divisor_band.h"
+#include "divisor_estimate.h"
+#include "divisor_hull.h"
+#include "divisor_piltz.h"
+#include "divisor_sum.h"
+#include "divisor_window.h"
+#include "fast_io.h"
+#include "floor_quotient.h"
+#include "hull_file.h"
+#include "lattice_sum.h"
+#include "modular.h"
+#include "parallel.h"
+
+// S() of both SPOJ solutions, checked by test_S()
+#define SPOJ_NO_MAIN
+#pragma GCC push_options
+namespace divcnt1 {
+#include "spoj_DIVCNT1.cpp"
+}
+#pragma GCC pop_options
+#pragma GCC push_options
+namespace afs3 {
+#include "spoj_AFS3.cpp"
+}
+#pragma GCC pop_options
+
 const double eps = 1e-9;
-std::pair<long long, long long>
-convex_hull(const long long &N, const long long &x1, const long long &y1,
-            const long long &x2, const std::function<double(long long)> &f,
-            const std::function<double(long long)> &df,
-            const std::function<bool(long long, long long)> &inside,
-            std::vector<std::pair<long long, long long>> &ret) {
-  // x1: from (inclusive)  x2: to (exclusive)
-  // Note that for concave function, the inside function means the points on f
-  // should be included
-  // but for convex function, the inside function means the outside
-  // return:
-  //   ret: the vertices of the convex hull under the function f
-  //   return value: the slope of the convex hull (x,y) at x1
-
-  // Assumptions:
-  // f(x) is positive on x1<=x<x2
-  // df(x) is monotonic
-  // df(x) has the same sign on x1<=x<x2
-  // (x1, y1) should be on the convex hull (I don't check it)
 
-  assert(x1 < x2);
-  const bool convex = df(x1) < df(x1 + 1);
-  if (!convex && inside(x1, y1) || convex && inside(x1, y1))
-    ret.emplace_back(std::make_pair(x1, y1));
-  if (x1 + 1 == x2)
-    return std::make_pair(0, 0);
+// Heap allocations so far, counted by the replacement of operator new below
+// for test_workspace(). Not inlined, so that the compiler does not mistake the
+// free() in operator delete for the release of a new.
+std::atomic<long long> allocations(0);
+__attribute__((noinline)) void *operator new(size_t size) {
+  ++allocations;
+  if (void *p = malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void *p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
 
-  const int sign = (df(x1) < 0) ? -1 : 1;
-  std::vector<std::pair<long long, long long>> stac; // (x, y)
-  std::pair<long long, long long> first_slope;
-  if (!convex) {
-    long long x = x1, y = y1;
-    if (sign == -1) {
-      stac.emplace_back(0, 1);
-      if ((long long)f(x1) == (long long)f(x1 + 1)) {
-        first_slope = std::make_pair(1, 0);
-        stac.emplace_back(1, 0);
-      } else {
-        std::pair<long long, long long> left = std::make_pair(1, 0),
-                                        right = std::make_pair(0, 1);
-        while (true) {
-          std::pair<long long, long long> mid = std::make_pair(
-              left.first + right.first, left.second + right.second);
-          if (x + mid.first < x2 &&
-              inside(x + mid.first, y + sign * mid.second)) {
-            right = mid;
-            stac.emplace_back(mid);
-          } else {
-            if (x + mid.first >= x2)
-              break;
-            if (sign * df(x + mid.first) * right.first >= right.second)
-              break;
-            left = mid;
-          }
-        }
-        /*printf("my: ");
-        for (const auto &i:stac)
-            printf("%lld/%lld, ",i.second,i.first);
-        printf("\n");*/
-        first_slope = stac.back();
-      }
-      while (true) {
-        std::pair<long long, long long> left, right;
-        right = stac.back();
-        stac.pop_back();
-        bool assigned = false;
-        std::pair<long long, long long> last;
-        while (x + right.first < x2 &&
-               inside(x + right.first, y + sign * right.second)) {
-          x += right.first;
-          y += sign * right.second;
-          if (x < x2) {
-            assigned = true;
-            last = std::make_pair(x, y);
-          }
-        }
-        if (assigned && last.second >= 0)
-          ret.emplace_back(last);
-        left = right;
-        while (!stac.empty()) {
-          right = stac.back();
-          if (x + right.first >= x2)
-            break;
-          if (inside(x + right.first, y + sign * right.second))
-            break;
-          stac.pop_back();
-          left = right;
-        }
-        if (stac.empty())
-          break;
-        while (true) {
-          std::pair<long long, long long> mid = std::make_pair(
-              left.first + right.first, left.second + right.second);
-          if (x + mid.first < x2 &&
-              inside(x + mid.first, y + sign * mid.second)) {
-            right = mid;
-            stac.emplace_back(mid);
-          } else {
-            if (x + mid.first >= x2)
-              break;
-            if (sign * df(x + mid.first) * right.first >= right.second)
-              break;
-            left = mid;
-          }
-        }
-      }
-      return first_slope;
-    } else {
-      stac.emplace_back(1, 0);
-      if ((long long)f(x1) == (long long)f(x1 + 1)) {
-        first_slope = std::make_pair(1, 0);
-      } else {
-        std::pair<long long, long long> left = std::make_pair(1, 0),
-                                        right = std::make_pair(0, 1);
-        while (true) {
-          std::pair<long long, long long> mid = std::make_pair(
-              left.first + right.first, left.second + right.second);
-          if (x + mid.first < x2 &&
-              inside(x + mid.first, y + sign * mid.second)) {
-            left = mid;
-            stac.emplace_back(mid);
-          } else {
-            if (x + mid.first >= x2)
-              break;
-            if (sign * df(x + mid.first) * right.first >= right.second)
-              break;
-            right = mid;
-          }
-        }
-        /*printf("my: ");
-        for (const auto &i:stac)
-            printf("%lld/%lld, ",i.second,i.first);
-        printf("\n");*/
-        first_slope = stac.back();
-      }
-      while (true) {
-        std::pair<long long, long long> left, right;
-        left = stac.back();
-        stac.pop_back();
-        bool assigned = false;
-        std::pair<long long, long long> last;
-        while (x + left.first < x2 &&
-               inside(x + left.first, y + sign * left.second)) {
-          x += left.first;
-          y += sign * left.second;
-          if (x < x2) {
-            assigned = true;
-            last = std::make_pair(x, y);
-          }
-        }
-        if (assigned && last.second >= 0)
-          ret.emplace_back(last);
-        right = left;
-        while (!stac.empty()) {
-          left = stac.back();
-          if (x + left.first >= x2)
-            break;
-          if (inside(x + left.first, y + sign * left.second))
-            break;
-          stac.pop_back();
-          right = left;
-        }
-        if (stac.empty())
-          break;
-        while (true) {
-          std::pair<long long, long long> mid = std::make_pair(
-              left.first + right.first, left.second + right.second);
-          if (x + mid.first < x2 &&
-              inside(x + mid.first, y + sign * mid.second)) {
-            left = mid;
-            stac.emplace_back(mid);
-          } else {
-            if (x + mid.first >= x2)
-              break;
-            double v = sign * df(x + mid.first);
-            if (sign * df(x + mid.first) * right.first >= right.second)
-              break;
-            right = mid;
-          }
-        }
-      }
-      return first_slope;
-    }
-  } else {
-    const auto &outside = inside;
-    if (sign == -1) {
-      long long x = x1, y = y1;
-      while (!outside(x, y))
-        ++y;
-      stac.emplace_back(1, 0);
-      long long y2 = f(x1 + 1);
-      while (!outside(x1 + 1, y2))
-        ++y2;
-      if (y == y2) {
-        first_slope = std::make_pair(1, 0);
-        stac.emplace_back(0, 1);
-      } else {
-        std::pair<long long, long long> left = std::make_pair(0, 1),
-                                        right = std::make_pair(1, 0);
-        while (true) {
-          std::pair<long long, long long> mid = std::make_pair(
-              left.first + right.first, left.second + right.second);
-          if (x + mid.first < x2 &&
-              outside(x + mid.first,
-                      y + sign * mid.second)) // take care! It should be
-                                              // equivalent to
-          // f(x+mid.first)<=y+sign*mid.second
-          {
-            right = mid;
-            stac.emplace_back(mid);
-          } else {
-            if (x + mid.first >= x2)
-              break;
-            if (sign * df(x + mid.first) * right.first <= right.second)
-              break;
-            left = mid;
-          }
-        }
-        /*printf("my: ");
-        for (const auto &i : stac)
-          printf("%lld/%lld, ", i.second, i.first);
-        printf("\n");*/
-        first_slope = stac.back();
-      }
-      while (true) {
-        std::pair<long long, long long> left, right;
-        right = stac.back();
-        stac.pop_back();
-        bool assigned = false;
-        std::pair<long long, long long> last;
-        while (x + right.first < x2 &&
-               outside(x + right.first, y + sign * right.second)) {
-          x += right.first;
-          y += sign * right.second;
-          if (x < x2) {
-            assigned = true;
-            last = std::make_pair(x, y);
-          } else
-            break;
-        }
-        if (assigned && last.second >= 0)
-          ret.emplace_back(last);
-        left = right;
-        while (!stac.empty()) {
-          right = stac.back();
-          if (x + right.first >= x2)
-            break;
-          if (outside(x + right.first, y + sign * right.second))
-            break;
-          left = right;
-          stac.pop_back();
-        }
-        if (stac.empty())
-          break;
-        while (true) {
-          std::pair<long long, long long> mid = std::make_pair(
-              left.first + right.first, left.second + right.second);
-          if (x + mid.first < x2 &&
-              outside(x + mid.first, y + sign * mid.second)) {
-            right = mid;
-            stac.emplace_back(mid);
-          } else {
-            if (x + mid.first >= x2)
-              break;
-            if (sign * df(x + mid.first) * right.first <= right.second)
-              break;
-            left = mid;
-          }
-        }
-      }
-      return first_slope;
-    } else {
-      long long x = x1, y = y1;
-      while (!outside(x, y))
-        ++y;
-      stac.emplace_back(0, 1);
-      long long y2 = f(x1 + 1);
-      while (!outside(x1 + 1, y2))
-        y2++;
-      if (y == y2) {
-        first_slope = std::make_pair(1, 0);
-        stac.emplace_back(1, 0);
-      } else {
-        std::pair<long long, long long> left = std::make_pair(0, 1),
-                                        right = std::make_pair(1, 0);
-        while (true) {
-          std::pair<long long, long long> mid = std::make_pair(
-              left.first + right.first, left.second + right.second);
-          if (x + mid.first < x2 &&
-              outside(
-                  x + mid.first,
-                  y + sign * mid.second)) // take care! It should be equivalent
-                                          // to
-                                          // f(x+mid.first)<=y+sign*mid.second
-          {
-            left = mid;
-            stac.emplace_back(mid);
-          } else {
-            if (x + mid.first >= x2)
-              break;
-            if (sign * df(x + mid.first) * right.first <= right.second)
-              break;
-            right = mid;
-          }
-        }
-        /*printf("my: ");
-        for (const auto &i : stac)
-          printf("%lld/%lld, ", i.second, i.first);
-        printf("\n");*/
-        first_slope = stac.back();
-      }
-      while (true) {
-        std::pair<long long, long long> left, right;
-        left = stac.back();
-        if (!left.first)
-          break;
-        stac.pop_back();
-        bool assigned = false;
-        std::pair<long long, long long> last;
-        while (x + left.first < x2 &&
-               outside(x + left.first, y + sign * left.second)) {
-          x += left.first;
-          y += sign * left.second;
-          if (x < x2) {
-            assigned = true;
-            last = std::make_pair(x, y);
-          } else
-            break;
-        }
-        if (assigned && last.second >= 0)
-          ret.emplace_back(last);
-        right = left;
-        while (!stac.empty()) {
-          left = stac.back();
-          if (x + left.first >= x2)
-            break;
-          if (outside(x + left.first, y + sign * left.second))
-            break;
-          right = left;
-          stac.pop_back();
-        }
-        if (stac.empty())
-          break;
-        while (true) {
-          std::pair<long long, long long> mid = std::make_pair(
-              left.first + right.first, left.second + right.second);
-          if (x + mid.first < x2 &&
-              outside(
-                  x + mid.first,
-                  y + sign * mid.second)) // take care! It should be equivalent
-                                          // to
-                                          // f(x+mid.first)<=y+sign*mid.second
-          {
-            left = mid;
-            stac.emplace_back(mid);
-          } else {
-            if (x + mid.first >= x2)
-              break;
-            if (sign * df(x + mid.first) * right.first <= right.second)
-              break;
-            right = mid;
-          }
-        }
-      }
-      return first_slope;
+// The hull of points given in order of x: a monotone chain that keeps only
+// the points where it turns strictly, clockwise below a concave function and
+// counterclockwise below a convex one.
+std::vector<std::pair<long long, long long>>
+monotone_chain(const std::vector<std::pair<long long, long long>> &points,
+               const bool &convex) {
+  std::vector<std::pair<long long, long long>> chain;
+  for (const auto &p : points) {
+    while (chain.size() >= 2) {
+      const auto &a = chain[chain.size() - 2], &b = chain.back();
+      __int128 cross = (__int128)(b.first - a.first) * (p.second - b.second) -
+                       (__int128)(b.second - a.second) * (p.first - b.first);
+      if (convex ? cross > 0 : cross < 0)
+        break;
+      chain.pop_back();
     }
+    chain.push_back(p);
+  }
+  return chain;
+}
+
+long long gcd(long long x, long long y) {
+  while (y) {
+    long long t = x % y;
+    x = y;
+    y = t;
   }
+  return x;
 }
 
+// The first slope convex_hull() returns for a hull, reduced.
 std::pair<long long, long long>
-brute_force_convex_hull(const long long &N, const long long &x1,
-                        const long long &y1, const long long &x2,
-                        const std::function<double(long long)> &f,
-                        const std::function<double(long long)> &df,
-                        const std::function<bool(long long, long long)> &inside,
-                        std::vector<std::pair<long long, long long>> &ret) {
-  assert(x1 < x2);
+first_slope_of(const std::vector<std::pair<long long, long long>> &hull) {
+  if (hull.size() < 2)
+    return std::make_pair(0, 0);
+  long long dx = std::abs(hull[1].first - hull[0].first),
+            dy = std::abs(hull[1].second - hull[0].second);
+  long long g = gcd(dx, dy);
+  return std::make_pair(dx / g, dy / g);
+}
 
-  std::function<long long(long long, long long)> gcd;
-  gcd = [&gcd](long long x, long long y) -> long long {
-    return y ? gcd(y, x % y) : x;
-  };
-  auto simplify = [&gcd](long long a,
-                         long long b) -> std::pair<long long, long long> {
-    long long g = gcd(a, b);
-    return std::make_pair(a / g, b / g);
-  };
+// Reference for convex_hull() in O(x2 - x1): the extreme point of every
+// column, found from f and corrected with inside, then a monotone chain.
+std::pair<long long, long long>
+reference_convex_hull(const long long & /* N */, const long long &x1,
+                      const long long &y1, const long long &x2,
+                      const std::function<double(long long)> &f,
+                      const std::function<double(long long)> &df,
+                      const std::function<bool(long long, long long)> &inside,
+                      std::vector<std::pair<long long, long long>> &ret) {
+  assert(x1 < x2);
 
   const bool convex = df(x1) < df(x1 + 1);
-  if (!convex && inside(x1, y1) || convex && inside(x1, y1))
+  if (inside(x1, y1))
     ret.emplace_back(std::make_pair(x1, y1));
   if (x1 + 1 == x2)
     return std::make_pair(0, 0);
 
-  const int sign = (df(x1) < 0) ? -1 : 1;
-  if (!convex) {
-    std::vector<std::pair<long long, long long>> points;
-    for (long long x = x1; x < x2; ++x) {
-      long long y = f(x) + eps;
-      if (x == x1)
-        y = y1;
+  std::vector<std::pair<long long, long long>> points;
+  for (long long x = x1; x < x2; ++x) {
+    long long y = f(x) + eps;
+    if (x == x1)
+      y = y1;
+    if (!convex) {
       while (!inside(x, y))
         --y;
-      points.emplace_back(x, y);
-    }
-    long long x = x1, y = y1;
-    if (sign == -1) {
-      for (long long now = 0;;) {
-        std::pair<long long, long long> min_slope;
-        size_t next = -1;
-        for (size_t i = now + 1; i < points.size(); ++i) {
-          std::pair<long long, long long> slope =
-              simplify(abs(points.at(i).second - points.at(now).second),
-                       abs(points.at(i).first - points.at(now).first));
-          if (next == -1 ||
-              next != -1 &&
-                  min_slope.first * slope.second >=
-                      slope.first * min_slope.second) {
-            next = i;
-            min_slope = slope;
-          }
-        }
-        if (next == -1)
-          break;
-        ret.emplace_back(points.at(next));
-        now = next;
-      }
     } else {
-      for (long long now = 0;;) {
-        std::pair<long long, long long> max_slope;
-        size_t next = -1;
-        for (size_t i = now + 1; i < points.size(); ++i) {
-          std::pair<long long, long long> slope =
-              simplify(abs(points.at(i).second - points.at(now).second),
-                       abs(points.at(i).first - points.at(now).first));
-          if (next == -1 ||
-              next != -1 &&
-                  max_slope.first * slope.second <=
-                      slope.first * max_slope.second) {
-            next = i;
-            max_slope = slope;
-          }
-        }
-        if (next == -1)
-          break;
-        ret.emplace_back(points.at(next));
-        now = next;
-      }
-    }
-  } else {
-    const auto &outside = inside;
-    std::vector<std::pair<long long, long long>> points;
-    for (long long x = x1; x < x2; ++x) {
-      long long y = f(x) + eps;
-      if (x == x1)
-        y = y1;
+      const auto &outside = inside;
       while (outside(x, y))
         --y;
       ++y;
-      points.emplace_back(x, y);
     }
-    long long x = x1, y = y1;
-    if (sign == -1) {
-      for (long long now = 0;;) {
-        std::pair<long long, long long> max_slope;
-        size_t next = -1;
-        for (size_t i = now + 1; i < points.size(); ++i) {
-          std::pair<long long, long long> slope =
-              simplify(abs(points.at(i).second - points.at(now).second),
-                       abs(points.at(i).first - points.at(now).first));
-          if (next == -1 ||
-              next != -1 &&
-                  max_slope.first * slope.second <=
-                      slope.first * max_slope.second) {
-            next = i;
-            max_slope = slope;
-          }
-        }
-        if (next == -1)
-          break;
-        ret.emplace_back(points.at(next));
-        now = next;
-      }
-    } else {
-      for (long long now = 0;;) {
-        std::pair<long long, long long> min_slope;
-        size_t next = -1;
-        for (size_t i = now + 1; i < points.size(); ++i) {
-          std::pair<long long, long long> slope =
-              simplify(abs(points.at(i).second - points.at(now).second),
-                       abs(points.at(i).first - points.at(now).first));
-          if (next == -1 ||
-              next != -1 &&
-                  min_slope.first * slope.second >=
-                      slope.first * min_slope.second) {
-            next = i;
-            min_slope = slope;
-          }
-        }
-        if (next == -1)
-          break;
-        ret.emplace_back(points.at(next));
-        now = next;
-      }
+    points.emplace_back(x, y);
+  }
+  std::vector<std::pair<long long, long long>> chain =
+      monotone_chain(points, convex);
+  ret.insert(ret.end(), chain.begin() + 1, chain.end());
+  return first_slope_of(ret);
+}
+
+// Checks lattice_sum() against summing x^i * y^j column by column, for
+// i, j <= 2, as far as the sums fit in __int128, and for i, j <= 1 modulo a
+// prime.
+template <typename Inside, typename Turned>
+void check_lattice_sum(long long x1, long long y1, long long x2,
+                       hull_shape shape, const Inside &inside,
+                       const Turned &turned) {
+  const bool convex = shape == convex_decrease || shape == convex_increase;
+  auto under = [&](long long x, long long y) {
+    return convex ? !inside(x, y) : inside(x, y);
+  };
+  auto top = [&](long long x) {
+    long long lo = 0, hi = 1; // under(x, lo) && !under(x, hi)
+    while (under(x, hi)) {
+      lo = hi;
+      hi *= 2;
+    }
+    while (hi - lo > 1) {
+      long long mid = (lo + hi) / 2;
+      if (under(x, mid))
+        lo = mid;
+      else
+        hi = mid;
     }
+    return lo;
+  };
+  const long double highest = std::max(top(x1), top(x2 - 1));
+  if ((long double)x2 * x2 * highest * highest * highest * (x2 - x1) > 1e37L)
+    return;
+  __int128 correct[3][3] = {};
+  for (long long x = x1; x < x2; ++x) {
+    __int128 F = top(x);
+    __int128 W[3] = {F, F * (F + 1) / 2, F * (F + 1) * (2 * F + 1) / 6};
+    __int128 X = 1;
+    for (int i = 0; i <= 2; ++i, X *= x)
+      for (int j = 0; j <= 2; ++j)
+        correct[i][j] += X * W[j];
   }
-  if ((int)ret.size() < 2)
-    return std::make_pair(0, 0);
-  return simplify(abs(ret.at(0).first - ret.at(1).first),
-                  abs(ret.at(0).second - ret.at(1).second));
+  lattice_sums<2> sums = lattice_sum<2>(x1, y1, x2, shape, inside, turned);
+  const unsigned long long P = 1000000007;
+  lattice_sums<1, modular<P>> sums_mod =
+      lattice_sum<1, modular<P>>(x1, y1, x2, shape, inside, turned);
+  for (int i = 0; i <= 2; ++i)
+    for (int j = 0; j <= 2; ++j) {
+      assert(sums.s[i][j] == correct[i][j]);
+      assert(i > 1 || j > 1 || sums_mod.s[i][j] == modular<P>(correct[i][j]));
+    }
+}
+
+// The same hull in __int128 coordinates, moved beyond 2^64 (by 2^80 to the
+// right and 2^70 up) and stitched from chunks.
+template <typename Inside, typename Turned>
+void check_wide_hull(
+    long long x1, long long y1, long long x2, hull_shape shape,
+    const Inside &inside, const Turned &turned,
+    const std::vector<std::pair<long long, long long>> &correct_hull,
+    const std::pair<long long, long long> &correct_first_slope) {
+  const __int128 dx = (__int128)1 << 80, dy = (__int128)1 << 70;
+  auto moved_inside = [&](const __int128 &x, const __int128 &y) {
+    return inside((long long)(x - dx), (long long)(y - dy));
+  };
+  auto moved_turned = [&](const __int128 &x, const __int128 &ddx,
+                          const __int128 &ddy) {
+    return turned((long long)(x - dx), (long long)ddx, (long long)ddy);
+  };
+  std::vector<std::pair<__int128, __int128>> correct;
+  for (const auto &p : correct_hull)
+    correct.emplace_back(p.first + dx, p.second + dy);
+  std::vector<std::pair<__int128, __int128>> hull;
+  std::pair<__int128, __int128> first_slope = convex_hull_parallel<__int128>(
+      x1 + dx, y1 + dy, x2 + dx, shape, moved_inside, moved_turned, hull, 1, 7);
+  assert(hull == correct);
+  assert(first_slope.first == correct_first_slope.first &&
+         first_slope.second == correct_first_slope.second);
+}
+
+// Checks the entry point taking f and df against the expected hull.
+template <typename F, typename DF, typename Inside>
+void check_f_df_mode(
+    long long N, long long x1, long long y1, long long x2, const F &f,
+    const DF &df, const Inside &inside,
+    const std::vector<std::pair<long long, long long>> &correct_hull,
+    const std::pair<long long, long long> &correct_first_slope) {
+  std::vector<std::pair<long long, long long>> hull;
+  const std::pair<long long, long long> first_slope =
+      convex_hull(N, x1, y1, x2, f, df, inside, hull);
+  assert(hull == correct_hull);
+  assert(first_slope == correct_first_slope);
+}
+
+// Checks the shape-tagged entry points, with and without turned, serial and
+// in parallel, against the expected hull, and the lattice sums under it.
+template <typename Inside, typename Turned>
+void check_lattice_modes(
+    long long x1, long long y1, long long x2, hull_shape shape,
+    const Inside &inside, const Turned &turned,
+    const std::vector<std::pair<long long, long long>> &correct_hull,
+    const std::pair<long long, long long> &correct_first_slope) {
+  std::vector<std::pair<long long, long long>> hull;
+  std::pair<long long, long long> first_slope =
+      convex_hull(x1, y1, x2, shape, inside, turned, hull);
+  assert(hull == correct_hull);
+  assert(first_slope == correct_first_slope);
+
+  hull.clear();
+  first_slope = convex_hull(x1, y1, x2, shape, inside, hull);
+  assert(hull == correct_hull);
+  assert(first_slope == correct_first_slope);
+
+  // the visitor has to see the same vertices in the same order
+  size_t visited = 0;
+  convex_hull(x1, y1, x2, shape, inside, turned,
+              [&](long long x, long long y) {
+                assert(visited < correct_hull.size());
+                assert(correct_hull[visited] == std::make_pair(x, y));
+                ++visited;
+              });
+  assert(visited == correct_hull.size());
+
+  // stitching the sub-hulls of several chunks must not change anything
+  for (long long chunks : {2, 7, 64}) {
+    hull.clear();
+    first_slope = convex_hull_parallel(x1, y1, x2, shape, inside, turned,
+                                       hull, 3, chunks);
+    assert(hull == correct_hull);
+    assert(first_slope == correct_first_slope);
+  }
+
+  check_lattice_sum(x1, y1, x2, shape, inside, turned);
+  check_wide_hull(x1, y1, x2, shape, inside, turned, correct_hull,
+                  correct_first_slope);
 }
 
 void test_concave_decrease(long long N, bool print_detail = false) {
@@ -539,7 +288,7 @@ void test_concave_decrease(long long N, bool print_detail = false) {
   }
 
   std::vector<std::pair<long long, long long>> correct_hull;
-  std::pair<long long, long long> correct_first_slope = brute_force_convex_hull(
+  std::pair<long long, long long> correct_first_slope = reference_convex_hull(
       N, x0, f(x0), sqrt(N), f, df, inside, correct_hull);
   if (print_detail) {
     for (const auto &i : correct_hull)
@@ -550,6 +299,13 @@ void test_concave_decrease(long long N, bool print_detail = false) {
 
   assert(hull == correct_hull);
   assert(first_slope == correct_first_slope);
+  check_lattice_modes(
+      x0, f(x0), sqrt(N), concave_decrease,
+      [&](long long x, long long y) { return y < 0 || x * x + y * y <= N; },
+      [&](long long x, long long dx, long long dy) {
+        return (__int128)x * x * dx * dx >= (__int128)dy * dy * (N - x * x);
+      },
+      correct_hull, correct_first_slope);
 
   printf("pass test_concave_decrease %lld\n", N);
 }
@@ -577,7 +333,7 @@ void test_concave_increase(long long N, bool print_detail = false) {
   }
 
   std::vector<std::pair<long long, long long>> correct_hull;
-  std::pair<long long, long long> correct_first_slope = brute_force_convex_hull(
+  std::pair<long long, long long> correct_first_slope = reference_convex_hull(
       N, x0, f(x0), sqrt(N), f, df, inside, correct_hull);
   if (print_detail) {
     for (const auto &i : correct_hull)
@@ -588,6 +344,13 @@ void test_concave_increase(long long N, bool print_detail = false) {
 
   assert(hull == correct_hull);
   assert(first_slope == correct_first_slope);
+  check_lattice_modes(
+      x0, f(x0), sqrt(N), concave_increase,
+      [&](long long x, long long y) { return y < 0 || inside(x, y); },
+      [&](long long x, long long dx, long long dy) {
+        return (sqrt(N) - x) * dx <= dy * f(x);
+      },
+      correct_hull, correct_first_slope);
 
   printf("pass test_concave_increase %lld\n", N);
 }
@@ -611,7 +374,7 @@ void test_convex_decrease(long long N, bool eq, bool print_detail = false) {
   }
 
   std::vector<std::pair<long long, long long>> correct_hull;
-  std::pair<long long, long long> correct_first_slope = brute_force_convex_hull(
+  std::pair<long long, long long> correct_first_slope = reference_convex_hull(
       N, x0, f(x0) + 1 - eq, N + 1, f, df, outside, correct_hull);
   if (print_detail) {
     for (const auto &i : correct_hull)
@@ -622,6 +385,12 @@ void test_convex_decrease(long long N, bool eq, bool print_detail = false) {
 
   assert(hull == correct_hull);
   assert(first_slope == correct_first_slope);
+  check_lattice_modes(
+      x0, f(x0) + 1 - eq, N + 1, convex_decrease, outside,
+      [&](long long x, long long dx, long long dy) {
+        return (__int128)N * dx <= (__int128)x * x * dy;
+      },
+      correct_hull, correct_first_slope);
 
   printf("pass test_convex_decrease %lld %d\n", N, (int)eq);
 }
@@ -649,7 +418,7 @@ void test_convex_increase(long long N, bool eq, bool print_detail = false) {
   }
 
   std::vector<std::pair<long long, long long>> correct_hull;
-  std::pair<long long, long long> correct_first_slope = brute_force_convex_hull(
+  std::pair<long long, long long> correct_first_slope = reference_convex_hull(
       N, x0, f(x0) + 1 - eq, N + 1, f, df, outside, correct_hull);
   if (print_detail) {
     for (const auto &i : correct_hull)
@@ -660,10 +429,675 @@ void test_convex_increase(long long N, bool eq, bool print_detail = false) {
 
   assert(hull == correct_hull);
   assert(first_slope == correct_first_slope);
+  check_lattice_modes(
+      x0, f(x0) + 1 - eq, N + 1, convex_increase, outside,
+      [&](long long x, long long dx, long long dy) {
+        return (__int128)N * dx >= (__int128)(N + 1 - x) * (N + 1 - x) * dy;
+      },
+      correct_hull, correct_first_slope);
 
   printf("pass test_convex_increase %lld %d\n", N, (int)eq);
 }
 
+long long isqrt(long long n) {
+  long long r = sqrtl(n);
+  while (r * r > n)
+    --r;
+  while ((r + 1) * (r + 1) <= n)
+    ++r;
+  return r;
+}
+
+// The end of the columns 1 <= x < end of the workload of shape for N in
+// test_random_hulls().
+long long hull_workload_end(hull_shape shape, long long N) {
+  switch (shape) {
+  case concave_decrease:
+    return isqrt(N - 1) + 1;
+  case concave_increase:
+    return isqrt(N);
+  default:
+    return N + 1;
+  }
+}
+
+// Checks every entry point on the window [x1, x2) of the workload of shape
+// for N. The expected hull is a monotone chain over the extreme points of
+// the columns, which are computed exactly.
+void check_hull_window(hull_shape shape, long long N, long long x1,
+                       long long x2) {
+  const long long c = isqrt(N);
+  // the extreme point of column x
+  std::function<long long(long long)> extreme;
+  switch (shape) {
+  case concave_decrease:
+    extreme = [&](long long x) { return isqrt(N - x * x); };
+    break;
+  case concave_increase:
+    extreme = [&](long long x) { return isqrt(N - (c - x) * (c - x)); };
+    break;
+  case convex_decrease:
+    extreme = [&](long long x) { return N / x + 1; };
+    break;
+  default:
+    extreme = [&](long long x) { return N / (N + 1 - x) + 1; };
+    break;
+  }
+
+  std::vector<std::pair<long long, long long>> points;
+  for (long long x = x1; x < x2; ++x)
+    points.emplace_back(x, extreme(x));
+  const bool convex = shape == convex_decrease || shape == convex_increase;
+  std::vector<std::pair<long long, long long>> correct_hull =
+      monotone_chain(points, convex);
+  const std::pair<long long, long long> correct_first_slope =
+      x2 - x1 == 1 ? std::make_pair(0LL, 0LL) : first_slope_of(correct_hull);
+  // each workload with f and df as well, in long double, for the entry
+  // point that takes them
+  auto check = [&](const auto &f, const auto &df, const auto &inside,
+                   const auto &turned) {
+    const long long y1 = points[0].second;
+    check_lattice_modes(x1, y1, x2, shape, inside, turned, correct_hull,
+                        correct_first_slope);
+    if (x2 - x1 >= 2)
+      check_f_df_mode(N, x1, y1, x2, f, df, inside, correct_hull,
+                      correct_first_slope);
+  };
+  switch (shape) {
+  case concave_decrease:
+    check([&](long long x) { return sqrtl(N - x * x); },
+          [&](long long x) { return -x / sqrtl(N - x * x); },
+          [&](long long x, long long y) {
+            return y < 0 || (__int128)x * x + (__int128)y * y <= N;
+          },
+          [&](long long x, long long dx, long long dy) {
+            return (__int128)x * x * dx * dx >=
+                   (__int128)dy * dy * (N - x * x);
+          });
+    break;
+  case concave_increase:
+    check([&](long long x) { return sqrtl(N - (c - x) * (c - x)); },
+          [&](long long x) {
+            return (c - x) / sqrtl(N - (c - x) * (c - x));
+          },
+          [&](long long x, long long y) {
+            return y < 0 ||
+                   (__int128)(c - x) * (c - x) + (__int128)y * y <= N;
+          },
+          [&](long long x, long long dx, long long dy) {
+            return (__int128)(c - x) * (c - x) * dx * dx <=
+                   (__int128)dy * dy * (N - (c - x) * (c - x));
+          });
+    break;
+  case convex_decrease:
+    check([&](long long x) { return (long double)N / x; },
+          [&](long long x) { return -(long double)N / x / x; },
+          [&](long long x, long long y) { return (__int128)x * y > N; },
+          [&](long long x, long long dx, long long dy) {
+            return (__int128)N * dx <= (__int128)x * x * dy;
+          });
+    break;
+  default:
+    check([&](long long x) { return (long double)N / (N + 1 - x); },
+          [&](long long x) {
+            return (long double)N / (N + 1 - x) / (N + 1 - x);
+          },
+          [&](long long x, long long y) {
+            return (__int128)(N + 1 - x) * y > N;
+          },
+          [&](long long x, long long dx, long long dy) {
+            return (__int128)N * dx >=
+                   (__int128)(N + 1 - x) * (N + 1 - x) * dy;
+          });
+    break;
+  }
+}
+
+// Differential test of the f/df and the shape-tagged entry points on random
+// windows [x1, x2) of the workloads of the test_* functions, with N up to
+// 1e12, after two windows where the f/df entry point took a start that is
+// flat for one column as flat to the end. Rounds are seeded by their index
+// and run on threads threads.
+void test_random_hulls(long long rounds, int threads = 0) {
+  check_hull_window(concave_increase, 15317610, 2748, 3519);
+  check_hull_window(convex_decrease, 1881, 658, 1280);
+  std::atomic<long long> columns(0);
+  parallel_for(rounds, threads, [&](long long round) {
+    std::mt19937_64 rng(round);
+    auto log_uniform = [&](double lo, double hi) -> long long {
+      return exp(std::uniform_real_distribution<double>(log(lo), log(hi))(
+          rng));
+    };
+    const hull_shape shape = hull_shape(round % 4);
+    const long long N = log_uniform(100, 1e12);
+    const long long lo = 1, hi = hull_workload_end(shape, N);
+    if (hi - lo < 2)
+      return;
+    const long long width =
+        std::min(hi - lo, log_uniform(2, 2e5 + 1));
+    const long long x1 =
+        std::uniform_int_distribution<long long>(lo, hi - width)(rng);
+    columns += width;
+    check_hull_window(shape, N, x1, x1 + width);
+  });
+  printf("pass test_random_hulls %lld rounds, %lld columns\n", rounds,
+         columns.load());
+}
+
+// The hull of xy > N from x = 1 starts with slopes near N, i.e. runs of
+// about N mediants: the stack keeps each run as one entry and backtracking
+// gallops over it, so the hull takes O(log N) probes per vertex and no
+// memory in N, where one probe and one entry per mediant ran out of memory
+// near N = 1e10.
+void test_steep_start(long long N) {
+  const long long x2 = 1000;
+  std::vector<std::pair<long long, long long>> points;
+  for (long long x = 1; x < x2; ++x)
+    points.emplace_back(x, N / x + 1);
+  const std::vector<std::pair<long long, long long>> correct_hull =
+      monotone_chain(points, true);
+  long long probes = 0;
+  auto outside = [&](long long x, long long y) {
+    ++probes;
+    return (__int128)x * y > N;
+  };
+  auto turned = [&](long long x, long long dx, long long dy) {
+    return (__int128)N * dx <= (__int128)x * x * dy;
+  };
+  check_lattice_modes(1, N + 1, x2, convex_decrease, outside, turned,
+                      correct_hull, first_slope_of(correct_hull));
+  for (int with_turned = 0; with_turned < 2; ++with_turned) {
+    probes = 0;
+    std::vector<std::pair<long long, long long>> hull;
+    if (with_turned)
+      convex_hull(1, N + 1, x2, convex_decrease, outside, turned, hull);
+    else
+      convex_hull(1, N + 1, x2, convex_decrease, outside, hull);
+    assert(hull == correct_hull);
+    assert(probes < 200 * x2);
+  }
+  printf("pass test_steep_start %lld\n", N);
+}
+
+// sum of floor(n / i) * i^k over 1 <= i <= n for k <= 2, a block of equal
+// quotients at a time
+__int128 quotient_sum(long long n, int k) {
+  auto power_sum = [&](__int128 i) { // 1^k + ... + i^k
+    return k == 0   ? i
+           : k == 1 ? i * (i + 1) / 2
+                    : i * (i + 1) * (2 * i + 1) / 6;
+  };
+  __int128 ret = 0;
+  for (long long i = 1, j; i <= n; i = j + 1) {
+    j = n / (n / i);
+    ret += (power_sum(j) - power_sum(i - 1)) * (n / i);
+  }
+  return ret;
+}
+
+// D(N) for N < 2^64, also beyond long long: 2 (N / 1 + ... + N / s) - s^2
+// with s = floor(sqrt(N)), each quotient estimated in double and corrected
+// by its remainder, which is small enough for long long.
+__int128 wide_divisor_count(unsigned long long N) {
+  unsigned long long s = sqrtl(N);
+  while ((unsigned __int128)s * s > N)
+    --s;
+  while ((unsigned __int128)(s + 1) * (s + 1) <= N)
+    ++s;
+  const double n = N;
+  __int128 sum = 0;
+  for (unsigned long long i = 1; i <= s; ++i) {
+    unsigned long long q = i < 4096 ? N / i : (unsigned long long)(n / i);
+    long long r = N - q * i;
+    for (; r < 0; r += i)
+      --q;
+    for (; r >= (long long)i; r -= i)
+      ++q;
+    sum += q;
+  }
+  return 2 * sum - (__int128)s * s;
+}
+
+// floor_quotients must give N / t for every t up to a bound, the reciprocals
+// being filled by several threads at once, and beyond the bound and the table
+// as well.
+void test_floor_quotients(long long rounds, int threads = 0) {
+  std::atomic<long long> checked(0);
+  parallel_for(rounds, threads, [&](long long round) {
+    std::mt19937_64 rng(round);
+    const long long N = round == 0 ? 9223372036854775807LL
+                        : round == 1 ? 1
+                                     : rng() >> (1 + rng() % 63);
+    const long long t_max = 1 + rng() % 3000000;
+    const floor_quotients<> quotient(N, t_max);
+    for (long long t = 1; t <= t_max; t += 1 + rng() % 16)
+      assert(quotient(t) == N / t), ++checked;
+    for (long long t : {t_max, t_max + 1, floor_reciprocal_capacity - 1,
+                        floor_reciprocal_capacity, 1LL << 40})
+      assert(quotient(t) == N / t);
+    const floor_quotients<__int128> wide((__int128)N << 40, t_max);
+    assert(wide(t_max) == ((__int128)N << 40) / t_max);
+  });
+  printf("pass test_floor_quotients %lld rounds, %lld quotients\n", rounds,
+         checked.load());
+}
+
+// Runs check(N, round, rng) for rounds rounds on threads threads, with N drawn
+// log-uniformly from [lo, hi] and rng seeded by the index of the round, so
+// that a failing round can be run again by itself.
+template <typename F>
+void random_rounds(long long rounds, int threads, double lo, double hi,
+                   F check) {
+  parallel_for(rounds, threads, [&](long long round) {
+    std::mt19937_64 rng(round);
+    const long long N =
+        exp(std::uniform_real_distribution<double>(log(lo), log(hi))(rng));
+    check(N, round, rng);
+  });
+}
+
+// Checks S() of both SPOJ solutions against summing the quotients directly:
+// every n up to small, then random n up to 1e12. DIVCNT1 is also checked in
+// __int128 coordinates and modulo 2^64 and a prime, and AFS3 on three
+// threads, for the small n and every eighth random one.
+void test_S(long long small, long long rounds, int threads = 0) {
+  auto check = [](long long n, bool rings) {
+    const __int128 D = quotient_sum(n, 0);
+    const __int128 sigma = quotient_sum(n, 1) - (__int128)n * (n + 1) / 2;
+    const unsigned long long P = 998244353;
+    assert(divcnt1::S(n) == D);
+    assert(afs3::S(n) == sigma);
+    if (!rings)
+      return;
+    assert(afs3::S(n, 3) == sigma);
+    assert((divcnt1::S<__int128, __int128>(n) == D));
+    assert(divcnt1::S<unsigned long long>(n) == (unsigned long long)D);
+    assert(divcnt1::S<modular<P>>(n) == modular<P>(D));
+  };
+  parallel_for(small, threads, [&](long long n) { check(n + 1, true); });
+  random_rounds(rounds, threads, 12, 1e12,
+                [&](long long n, long long round, std::mt19937_64 &) {
+                  check(n, round % 8 == 0);
+                });
+  // just below a square beyond 2^53, where N + 0.5 rounds up to the square
+  for (long long k : {100000000LL, 123456789LL, 1000000000LL}) {
+    const long long n = k * k - 1;
+    assert((divcnt1::S(n) == divcnt1::S<__int128, __int128>(n)));
+  }
+  printf("pass test_S %lld small, %lld random\n", small, rounds);
+}
+
+// The brute-force check main() of AFS3 used to keep commented out: by the
+// hyperbola method, sum of sigma(n) over n <= N is the sum over i <= v =
+// floor(sqrt(N)) of L * (L + 1 + 2i) / 2 with L = N / i, less v * W(v). The
+// i go by their part coprime to 6 and then by powers of 3 and 2, halving L
+// instead of dividing it.
+__int128 afs3_reference(unsigned long long n) {
+  __uint128_t correct = 0;
+  unsigned long long v = sqrtl(n);
+  while (v * v > n)
+    --v;
+  while ((v + 1) * (v + 1) <= n)
+    ++v;
+  for (unsigned long long beg : {1, 5})
+    for (unsigned long long i = beg; i <= v; i += 6)
+      for (unsigned long long M = n / i, j = i; j <= v; j *= 3, M /= 3)
+        for (unsigned long long L = M, k = j; k <= v; k <<= 1, L >>= 1)
+          correct += __uint128_t(L) * (L + 1 + 2 * k);
+  correct /= 2;
+  correct -= __uint128_t(v) * v * (v + 1) / 2;
+  correct -= (n & 1) ? ((__uint128_t)n + 1) / 2 * n
+                     : (__uint128_t)n / 2 * (n + 1);
+  return correct;
+}
+
+// S() of both SPOJ solutions at the largest N they take, 2^63 - 1, where the
+// sum of sigma comes within a factor 2.5 of 2^127, against divisor_sum<1>();
+// AFS3 against the brute force above where that is fast; and DIVCNT1 in
+// __int128 coordinates just beyond 2^63, against summing the quotients.
+void test_S_limit() {
+  for (long long n : {1000000000000000LL, 999999999999999LL})
+    assert(afs3::S(n) == afs3_reference(n));
+  const long long N = 9223372036854775807LL;
+  const divisor_sums<1> sums = divisor_sum<1>(N);
+  const __int128 W = (__int128)(N / 2 + 1) * N;
+  assert(divcnt1::S(N) == sums.sigma[0]);
+  assert(afs3::S(N) == sums.sigma[1] - W);
+  const unsigned long long wide = (1ULL << 63) + 12345;
+  assert((divcnt1::S<__int128, __int128>((__int128)wide) ==
+          wide_divisor_count(wide)));
+  printf("pass test_S_limit %lld, %llu\n", N, wide);
+}
+
+// Checks divisor_sum() against summing the quotients directly: every n up to
+// small, then random n up to 1e12, where the sum of sigma_2 still fits in
+// __int128. It is also checked modulo 2^64 and a prime, on three threads and
+// with K = 0, for the small n and every eighth random one.
+void test_divisor_sum(long long small, long long rounds, int threads = 0) {
+  auto check = [](long long n, bool rings) {
+    const __int128 sigma[3] = {quotient_sum(n, 0), quotient_sum(n, 1),
+                               quotient_sum(n, 2)};
+    const unsigned long long P = 998244353;
+    const divisor_sums<2> sums = divisor_sum<2>(n);
+    for (int k = 0; k <= 2; ++k)
+      assert(sums.sigma[k] == sigma[k]);
+    if (!rings)
+      return;
+    const divisor_sums<2> parallel = divisor_sum<2>(n, 3);
+    const divisor_sums<2, unsigned long long> wrapped =
+        divisor_sum<2, unsigned long long>(n);
+    const divisor_sums<2, modular<P>> mod = divisor_sum<2, modular<P>>(n);
+    for (int k = 0; k <= 2; ++k) {
+      assert(parallel.sigma[k] == sigma[k]);
+      assert(wrapped.sigma[k] == (unsigned long long)sigma[k]);
+      assert(mod.sigma[k] == modular<P>(sigma[k]));
+    }
+    assert(divisor_sum<0>(n).sigma[0] == sigma[0]);
+  };
+  parallel_for(small, threads, [&](long long n) { check(n + 1, true); });
+  random_rounds(rounds, threads, 12, 1e12,
+                [&](long long n, long long round, std::mt19937_64 &) {
+                  check(n, round % 8 == 0);
+                });
+  printf("pass test_divisor_sum %lld small, %lld random\n", small, rounds);
+}
+
+// The intervals of divisor_estimate.h must hold the exact sums: every n up to
+// small, then random n up to 1e12 and a few near 1e15 and 2^63, D(N) also
+// with some of its columns counted exactly, and with all of them (X = 0) down
+// to the rounding of long double.
+void test_divisor_estimate(long long small, long long rounds, int threads = 0) {
+  auto contains = [](const divisor_estimate &e, const __int128 &exact) {
+    return e.low <= (long double)exact && (long double)exact <= e.high;
+  };
+  auto check = [&](long long n, const __int128 &D, const __int128 &sigma) {
+    const long long s = divisor_hull_x0(n);
+    for (long long X : {-1LL, 0LL, 1LL, s / 10, s / 2, s - 1})
+      assert(contains(divisor_count_estimate(n, X), D));
+    const divisor_estimate all = divisor_count_estimate(n, 0);
+    assert(all.high - all.low < 3 + all.high * 1e-17L);
+    assert(contains(divisor_sigma_estimate(n), sigma));
+  };
+  parallel_for(small, threads, [&](long long n) {
+    check(n + 1, quotient_sum(n + 1, 0), quotient_sum(n + 1, 1));
+  });
+  random_rounds(rounds, threads, 12, 1e12,
+                [&](long long n, long long, std::mt19937_64 &) {
+                  check(n, quotient_sum(n, 0), quotient_sum(n, 1));
+                });
+  for (long long n : {1000000000000000LL, 1000000000000037LL,
+                      9223372036854775807LL}) {
+    const divisor_sums<1> exact = divisor_sum<1>(n);
+    for (long long X : {-1LL, divisor_hull_x0(n) / 2})
+      assert(contains(divisor_count_estimate(n, X), exact.sigma[0]));
+    assert(contains(divisor_sigma_estimate(n), exact.sigma[1]));
+  }
+  const divisor_estimate D = divisor_count_estimate(1e18);
+  printf("pass test_divisor_estimate %lld small, %lld random; D(1e18) in "
+         "%.0Lf +- %.0Lf\n",
+         small, rounds, (D.low + D.high) / 2, (D.high - D.low) / 2);
+}
+
+// divisor_count_window() must hand out every N of the window in order with
+// D(N): checked against summing the quotients for the N up to small and
+// for a sample of random windows up to 1e12, and at the end of windows near
+// 1e15, 1e18 and 2^63 - 1 against divisor_sum(). The short windows sieve up
+// to cbrt(B) and leave most N to Miller-Rabin.
+void test_divisor_window(long long small, long long rounds, int threads = 0) {
+  std::atomic<long long> checked(0);
+  auto check = [&](long long A, long long B, long long every) {
+    long long next = A;
+    divisor_count_window(A, B, [&](long long n, const __int128 &D) {
+      assert(n == next++);
+      if ((n - A) % every == 0 || n == B)
+        assert(D == quotient_sum(n, 0)), ++checked;
+    });
+    assert(next == B + 1);
+  };
+  check(1, small, 1);
+  random_rounds(rounds, threads, 1, 1e12,
+                [&](long long A, long long, std::mt19937_64 &rng) {
+                  const long long B = A + rng() % 200000;
+                  check(A, B, (B - A) / 8 + 1);
+                });
+  for (long long A : {1000000000000000LL, 1000000000000000000LL,
+                      9223372036854775807LL - 100000}) {
+    const long long B = A + (A < 1e18 ? 1000000 : 100000);
+    __int128 last = 0;
+    divisor_count_window(A, B, [&](long long, const __int128 &D) { last = D; });
+    assert(last == divisor_sum<0>(B).sigma[0]);
+  }
+  printf("pass test_divisor_window %lld small, %lld random, %lld checked\n",
+         small, rounds, checked.load());
+}
+
+// divisor_count_between() must give D(N) - D(M): for every M <= N up to
+// small, for random bands of every width up to 1e12 against summing the
+// quotients, and for a few bands near 1e15 against divisor_sum(), sieved up
+// to a width of 1e5 and taken on the hulls beyond.
+void test_divisor_band(long long small, long long rounds, int threads = 0) {
+  parallel_for(small + 1, threads, [&](long long N) {
+    for (long long M = 0; M <= N; ++M)
+      assert(divisor_count_between(M, N) ==
+             quotient_sum(N, 0) - quotient_sum(M, 0));
+  });
+  random_rounds(rounds, threads, 12, 1e12,
+                [&](long long N, long long, std::mt19937_64 &rng) {
+                  const long long H = std::min<long long>(
+                      N, exp(std::uniform_real_distribution<double>(
+                             0, log(N))(rng)) - 1);
+                  assert(divisor_count_between(N - H, N) ==
+                         quotient_sum(N, 0) - quotient_sum(N - H, 0));
+                });
+  const long long N = 1e15;
+  const __int128 D = divisor_sum<0>(N).sigma[0];
+  for (long long H : {1LL, 1000LL, 100000LL, 100001LL, 10000000LL})
+    assert(divisor_count_between(N - H, N) ==
+           D - divisor_sum<0>(N - H).sigma[0]);
+  printf("pass test_divisor_band %lld small, %lld random\n", small, rounds);
+}
+
+// divisor_count_3() must match the sum of d_3(n), sieved, for every N up to
+// small, and the sum of D(N / a) over the blocks of equal N / a for random N
+// up to 1e10; the hulls take over beyond 1e9. Near 1e12 it must not depend
+// on the number of threads.
+void test_divisor_count_3(long long small, long long rounds, int threads = 0) {
+  std::vector<long long> d(small + 1), d3(small + 1);
+  for (long long i = 1; i <= small; ++i)
+    for (long long j = i; j <= small; j += i)
+      ++d[j];
+  for (long long i = 1; i <= small; ++i)
+    for (long long j = i; j <= small; j += i)
+      d3[j] += d[j / i];
+  __int128 D3 = 0;
+  for (long long N = 0; N <= small; ++N) {
+    D3 += d3[N];
+    assert(divisor_count_3(N) == D3);
+  }
+  random_rounds(rounds, threads, small, 1e10,
+                [&](long long N, long long, std::mt19937_64 &) {
+                  __int128 expected = 0;
+                  for (long long a = 1, b; a <= N; a = b + 1) {
+                    b = N / (N / a);
+                    expected += (b - a + 1) * quotient_sum(N / a, 0);
+                  }
+                  assert(divisor_count_3(N) == expected);
+                });
+  const long long N = 1e12;
+  assert(divisor_count_3(N, 1) == divisor_count_3(N, 4));
+  printf("pass test_divisor_count_3 %lld small, %lld random\n", small, rounds);
+}
+
+// Once a workspace is warm, building the same hull again, serially or from
+// chunks, and answering the same S() queries must not allocate.
+void test_workspace() {
+  const long long N = 1e12;
+  auto outside = [&](long long x, long long y) {
+    return (__int128)x * y > (__int128)N;
+  };
+  auto turned = [&](long long x, long long dx, long long dy) {
+    return (__int128)N * dx <= (__int128)x * x * dy;
+  };
+  const long long x0 = sqrtl(N + 0.5), x1 = cbrtl(N) * cbrtl(N);
+  hull_workspace work(N, 40000);
+  long long vertices = 0;
+  auto visit = [&](long long, long long) { ++vertices; };
+  for (long long chunks : {1, 8})
+    for (int round = 0; round < 2; ++round) {
+      const long long before = allocations;
+      convex_hull_parallel(x0 + 1, N / (x0 + 1) + 1, x1, convex_decrease,
+                           outside, turned, visit, 1, chunks, &work);
+      assert(round == 0 || allocations == before);
+    }
+  for (int round = 0; round < 2; ++round) {
+    const long long before = allocations;
+    divcnt1::S(N);
+    afs3::S(N);
+    assert(round == 0 || allocations == before);
+  }
+  printf("pass test_workspace %lld\n", N);
+}
+
+// A hull written by hull_encoder must read back the same from memory and
+// from a file, a truncated one must not, and S() of both SPOJ solutions and
+// divisor_sum() must give the same answer from the file as from the hull they
+// build. Given the file of another N, they must build their own hull.
+void test_hull_file() {
+  typedef std::vector<std::pair<long long, long long>> hull_type;
+  auto read_back = [](const hull_view &view) {
+    hull_type hull;
+    view.for_each([&](long long x, long long y) { hull.emplace_back(x, y); });
+    assert((long long)hull.size() == view.size());
+    return hull;
+  };
+  auto encode = [](const hull_type &hull) {
+    hull_encoder encoder;
+    for (const auto &p : hull)
+      encoder(p.first, p.second);
+    return encoder.bytes();
+  };
+  for (const hull_type &hull :
+       {hull_type{{-5, 3}},
+        hull_type{{-5, 3}, {0, 3}, {2, 7}, {3, 8}, {10, -100}},
+        hull_type{{1, -(1LL << 62)}, {(1LL << 62) + 1, 1LL << 62}}}) {
+    const std::vector<unsigned char> bytes = encode(hull);
+    assert(read_back(hull_view(bytes.data(), bytes.size())) == hull);
+    assert(!hull_view(bytes.data(), bytes.size() - 1).valid());
+  }
+
+  const long long N = 1e12;
+  hull_type hull;
+  hull_encoder encoder(N);
+  divisor_hull(N, hull);
+  divisor_hull(N, encoder);
+  const std::vector<unsigned char> bytes = encoder.bytes();
+  assert(read_back(hull_view(bytes.data(), bytes.size())) == hull);
+
+  char path[] = "/tmp/hull_file_XXXXXX";
+  const int fd = mkstemp(path);
+  assert(fd >= 0);
+  close(fd);
+  assert(encoder.save(path));
+  {
+    const hull_view view(path);
+    assert(read_back(view) == hull);
+    assert(view.holds(N) && !view.holds(N + 1));
+    for (long long n : {N, N + 1}) {
+      assert(divcnt1::S(n, 1, &view) == divcnt1::S(n));
+      assert(afs3::S(n, 1, &view) == afs3::S(n));
+      const divisor_sums<2> from_file = divisor_sum<2>(n, 1, &view),
+                            built = divisor_sum<2>(n);
+      for (int k = 0; k <= 2; ++k)
+        assert(from_file.sigma[k] == built.sigma[k]);
+    }
+  }
+  unlink(path);
+  assert(!hull_view(path).valid());
+  printf("pass test_hull_file %lld: %zu vertices in %zu bytes\n", N,
+         hull.size(), bytes.size());
+}
+
+// What fast_output writes must be the decimal digits of each number, around
+// the 19-digit chunks of 128-bit numbers and at the limits of each type, and
+// fast_input must read it back from a mapped file, from a pipe, and at an
+// offset. Input ending without a newline must still give its last number.
+void test_fast_io() {
+  const __int128 ten19 = 10000000000000000000ULL, ten38 = ten19 * ten19,
+                 max = (__int128)(~(unsigned __int128)0 >> 1), min = -max - 1;
+  const std::vector<__int128> values = {
+      0, -1, 42, ten19 - 1, ten19, ten38, -ten38 - 7, max, min};
+  const char *const text = "0 -1 42 9999999999999999999 10000000000000000000 "
+                           "100000000000000000000000000000000000000 "
+                           "-100000000000000000000000000000000000007 "
+                           "170141183460469231731687303715884105727 "
+                           "-170141183460469231731687303715884105728\n"
+                           "9223372036854775807 -9223372036854775808 "
+                           "18446744073709551615 "
+                           "340282366920938463463374607431768211455\n";
+  char path[] = "/tmp/fast_io_XXXXXX";
+  const int fd = mkstemp(path);
+  assert(fd >= 0);
+  unlink(path);
+  {
+    fast_output out(fd);
+    for (size_t i = 0; i < values.size(); ++i) {
+      out.write(values[i]);
+      out.put(i + 1 < values.size() ? ' ' : '\n');
+    }
+    out.write(9223372036854775807LL), out.put(' ');
+    out.write((long long)(-9223372036854775807LL - 1)), out.put(' ');
+    out.write(~0ULL), out.put(' ');
+    out.write(~(unsigned __int128)0), out.put('\n');
+  }
+  const size_t size = strlen(text);
+  std::vector<char> written(size + 1);
+  assert(pread(fd, written.data(), size + 1, 0) == (ssize_t)size);
+  assert(memcmp(written.data(), text, size) == 0);
+
+  auto check = [&](fast_input &in) {
+    __int128 x;
+    for (const __int128 &v : values)
+      assert(in.read(x) && x == v);
+    long long a, b;
+    unsigned long long c;
+    unsigned __int128 d;
+    assert(in.read(a) && a == 9223372036854775807LL);
+    assert(in.read(b) && b == -9223372036854775807LL - 1);
+    assert(in.read(c) && c == ~0ULL);
+    assert(in.read(d) && d == ~(unsigned __int128)0);
+    assert(!in.read(x));
+  };
+  lseek(fd, 0, SEEK_SET);
+  {
+    fast_input in(fd);
+    check(in);
+  }
+  int ends[2];
+  assert(pipe(ends) == 0);
+  assert(write(ends[1], text, size) == (ssize_t)size);
+  close(ends[1]);
+  {
+    fast_input in(ends[0]);
+    check(in);
+  }
+  close(ends[0]);
+
+  // skip what comes before the offset; no newline at the end
+  assert(ftruncate(fd, 0) == 0);
+  const char *const tail = "5 6 -77";
+  assert(pwrite(fd, tail, strlen(tail), 0) == (ssize_t)strlen(tail));
+  lseek(fd, 2, SEEK_SET);
+  {
+    fast_input in(fd);
+    long long x;
+    assert(in.read(x) && x == 6);
+    assert(in.read(x) && x == -77);
+    assert(!in.read(x));
+  }
+  close(fd);
+  printf("pass test_fast_io\n");
+}
+
 int main() {
   test_concave_decrease(100);
   test_concave_decrease(101);
@@ -689,5 +1123,20 @@ int main() {
   test_convex_increase(101, true);
   test_convex_increase(1e6 + 7, true);
 
+  test_workspace();
+  test_hull_file();
+  test_fast_io();
+  test_random_hulls(2000);
+  test_steep_start(1e10);
+  test_steep_start(1e18);
+  test_floor_quotients(64);
+  test_S(3000, 1000);
+  test_S_limit();
+  test_divisor_sum(3000, 300);
+  test_divisor_estimate(3000, 300);
+  test_divisor_window(100000, 40);
+  test_divisor_band(300, 300);
+  test_divisor_count_3(3000, 40);
+
   return 0;
 }
@@ -0,0 +1,75 @@
+#ifndef DIVISOR_BAND_H
+#define DIVISOR_BAND_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "divisor_hull.h"
+#include "divisor_sum.h"
+#include "divisor_window.h"
+#include "floor_quotient.h"
+
+// D(N) - D(M), the lattice points of the band M < x * y <= N, in one pass
+// over the columns both hyperbolas share.
+//
+// With s = floor(sqrt(M)) and t = floor(sqrt(N)), every point of the band
+// with x < y has x <= t; mirrored, these are all its points but the squares
+// M < x * x <= N, which number t - s. Below s the band takes all of a column
+// x, N / x - M / x points; between s and t it is cut by the diagonal, N / x - x
+// points. Up to X = 2 N^(1/3) the columns are taken one by one, from one
+// quotient of each curve; beyond, where both curves are flat in mirror image,
+// by the hull of each.
+//
+// Where the band is thinner than a row, its points are the n in (M, N] with
+// a divisor x in the range, which no hull finds faster than by counting
+// under both curves: the cost is that of two hulls whatever the width, about
+// that of S() of DIVCNT1 twice, and half that of divisor_sum<0>() twice. A
+// band of at most N^(1/3) values of n is therefore summed as d(n) over the
+// window (M, N] instead, which costs less than the hulls up to about there.
+
+// The sum of C / x over X < x <= S for S <= sqrt(C): the square
+// (C / S) * (S - X) and the rows C / S < y <= C / (X + 1) holding C / y - X
+// points each, which divisor_hull_count() sums on their hull.
+inline __int128 divisor_band_columns(const long long &C, const long long &X,
+                                     const long long &S, int threads = 1,
+                                     hull_workspace *work = nullptr) {
+  const long long low = C / S, Y = C / (X + 1);
+  __int128 ret = (__int128)low * (S - X);
+  if (Y > low)
+    ret += divisor_hull_count(C, low + 1, Y + 1, threads, work) -
+           (__int128)X * (Y - low);
+  return ret;
+}
+
+// D(N) - D(M), the sum of d(n) over M < n <= N, for 0 <= M <= N < 2^63. A
+// band of at most N^(1/3) values of n is sieved, and one so wide that it
+// reaches 2 N^(1/3) columns past sqrt(M) goes the way of two full sums.
+inline __int128 divisor_count_between(const long long &M, const long long &N,
+                                      int threads = 1) {
+  assert(0 <= M && M <= N);
+  if (N - M <= (long long)cbrtl(N)) {
+    __int128 band = 0;
+    if (M < N)
+      divisor_window_counts(M + 1, N,
+                            [&](long long, unsigned d) { band += d; });
+    return band;
+  }
+  const long long s = M ? divisor_hull_x0(M) : 0, t = divisor_hull_x0(N),
+                  X = std::min(s, 2 * (long long)cbrtl(N));
+  if (M < 12 || t - s > X)
+    return divisor_sum<0>(N, threads).sigma[0] -
+           (M ? divisor_sum<0>(M, threads).sigma[0] : 0);
+  __int128 band = 0;
+  const floor_quotients<> quotient_N(N, X), quotient_M(M, X);
+  for (long long x = 1; x <= X; ++x)
+    band += quotient_N(x) - quotient_M(x);
+  if (X < s)
+    band += divisor_band_columns(N, X, s, threads) -
+            divisor_band_columns(M, X, s, threads);
+  for (long long x = s + 1; x <= t; ++x)
+    band += N / x - x;
+  return 2 * band + (t - s);
+}
+
+#endif
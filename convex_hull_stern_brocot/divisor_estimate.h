@@ -0,0 +1,122 @@
+#ifndef DIVISOR_ESTIMATE_H
+#define DIVISOR_ESTIMATE_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+
+#include "divisor_hull.h"
+#include "floor_quotient.h"
+
+// D(N) and the sum of sigma(n) over n <= N in O(1), as their asymptotic terms
+// together with an interval certain to hold the exact value.
+//
+// Both come from the hyperbola method with s = floor(sqrt(N)):
+//   D(N) = 2 * sum over x <= s of N / x - s^2,
+//   sum of sigma = sum over x <= s of x * (N / x)
+//                + sum over y <= s of W(N / y) - s * W(s),
+// W(y) = y * (y + 1) / 2. Writing N / x = N * (1 / x) - f with 0 <= f < 1
+// leaves the harmonic sums H(s) = 1 + ... + 1 / s and Z(s) = 1 + ... + 1 / s^2,
+// bracketed by Euler-Maclaurin, and the f, bracketed by 0 and 1. The width of
+// the interval is about 2 * sqrt(N) for D(N) and N * log(N) / 2 for the sum of
+// sigma, where the true error terms are O(N^(1/3)) and O(N log N). The sums
+// are taken in long double, and the interval is widened by far more than their
+// rounding.
+
+struct divisor_estimate {
+  long double main;      // the asymptotic terms
+  long double low, high; // the exact value is in [low, high]
+};
+
+namespace divisor_estimate_detail {
+
+const long double euler_gamma = 0.577215664901532860606512090082402431L,
+                  zeta_2 = 1.644934066848226436472415166646025189L;
+
+// H(n) = 1 + 1 / 2 + ... + 1 / n for n >= 1 lies in
+// [log n + gamma + 1 / (2n) - 1 / (12n^2), that + 1 / (120n^4)].
+inline std::pair<long double, long double> harmonic(const long long &n) {
+  const long double x = n;
+  const long double low =
+      logl(x) + euler_gamma + 1 / (2 * x) - 1 / (12 * x * x);
+  return std::make_pair(low, low + 1 / (120 * x * x * x * x));
+}
+
+// Z(n) = 1 + 1 / 4 + ... + 1 / n^2 for n >= 1: the tail beyond n lies in
+// [1 / n - 1 / (2n^2), that + 1 / (6n^3)].
+inline std::pair<long double, long double> zeta_2_partial(const long long &n) {
+  const long double x = n, tail = 1 / x - 1 / (2 * x * x);
+  return std::make_pair(zeta_2 - tail - 1 / (6 * x * x * x), zeta_2 - tail);
+}
+
+// Widens [low, high] by the rounding of sums whose terms add up to magnitude.
+inline void widen(divisor_estimate &ret, const long double &magnitude) {
+  const long double pad = 64 * LDBL_EPSILON * magnitude + 1;
+  ret.low -= pad, ret.high += pad;
+}
+
+} // namespace divisor_estimate_detail
+
+// D(N) = N log N + (2 gamma - 1) N + O(N^(1/3)) for N >= 1. Given
+// exact_above = X < floor(sqrt(N)), the columns X < x <= sqrt(N) are counted
+// exactly, which narrows the interval to about 2 * X. Beyond about N^(1/3)
+// they are taken from the hull of N / y for sqrt(N) < y <= N / X
+// (divisor_hull_range()). That hull is densest next to sqrt(N): near 1e18,
+// X = sqrt(N) / 10 already takes most of the time of S() of DIVCNT1.
+inline divisor_estimate divisor_count_estimate(const long long &N,
+                                               long long exact_above = -1) {
+  using namespace divisor_estimate_detail;
+  const long double n = N;
+  divisor_estimate ret;
+  ret.main = n * logl(n) + (2 * euler_gamma - 1) * n;
+  const long long s = divisor_hull_x0(N);
+  const long long X = exact_above < 0 ? s : std::min(exact_above, s);
+  // the columns above X, exactly: one by one where N / x is steep, and from
+  // there on as their mirror image, where the hull is flat and cheap. The
+  // points X' < x <= s below N / x are the square s * (s - X') and the rows
+  // s < y <= Y = N / (X' + 1), which hold N / y - X' each.
+  const long long steep = std::min(s, 2 * (long long)cbrtl(N));
+  __int128 exact = 0;
+  if (X < steep) {
+    const floor_quotients<> quotient(N, steep);
+    for (long long x = X + 1; x <= steep; ++x)
+      exact += quotient(x);
+  }
+  const long long from = std::max(X, steep), Y = N / (from + 1);
+  exact += (__int128)s * (s - from);
+  if (from < s && Y > s)
+    exact += divisor_hull_count(N, s + 1, Y + 1) - (__int128)from * (Y - s);
+  // the columns up to X: N * H(X) less fractional parts, none for x = 1
+  const long double base = 2 * (long double)exact - (long double)s * s;
+  ret.low = ret.high = base;
+  long double magnitude = fabsl(base);
+  if (X > 0) {
+    const std::pair<long double, long double> H = harmonic(X);
+    ret.low += 2 * (n * H.first - (X - 1));
+    ret.high += 2 * n * H.second;
+    magnitude += 2 * n * H.second;
+  }
+  widen(ret, magnitude);
+  return ret;
+}
+
+// The sum of sigma(n) over n <= N, N >= 1: pi^2 N^2 / 12 + O(N log N).
+inline divisor_estimate divisor_sigma_estimate(const long long &N) {
+  using namespace divisor_estimate_detail;
+  const long double n = N;
+  divisor_estimate ret;
+  ret.main = zeta_2 * n * n / 2;
+  const long long s = divisor_hull_x0(N);
+  const long double x = s, W = x * (x + 1) / 2;
+  const std::pair<long double, long double> H = harmonic(s),
+                                            Z = zeta_2_partial(s);
+  // q = N / y - f: W(q) lies in [((N / y)^2 - N / y - 1 / 4) / 2,
+  // ((N / y)^2 + N / y) / 2]
+  ret.low = n * x - W + (n * n * Z.first - n * H.second - x / 4) / 2 - x * W;
+  ret.high = n * x + (n * n * Z.second + n * H.second) / 2 - x * W;
+  widen(ret, n * x + W + (n * n * Z.second + n * H.second) / 2 + x * W);
+  return ret;
+}
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef DIVISOR_HULL_H
+#define DIVISOR_HULL_H
+
+#include <cmath>
+#include <utility>
+
+#include "convex_hull.h"
+
+// The hull both SPOJ solutions sum over: the lowest lattice points strictly
+// above y = N / x, (x, N / x + 1), for divisor_hull_x0(N) < x <
+// divisor_hull_x1(N). The columns left of it are the mirror image of the rows
+// beyond it, and S() takes the few points per row past x1 one row at a time.
+
+// a * b <= c * d for a, b, c, d >= 0, with the products in 256 bits
+inline bool product_le(unsigned __int128 a, unsigned __int128 b,
+                       unsigned __int128 c, unsigned __int128 d) {
+  auto product = [](unsigned __int128 a, unsigned __int128 b,
+                    unsigned __int128 &high, unsigned __int128 &low) {
+    const unsigned __int128 mask = ~0ULL;
+    unsigned __int128 p00 = (a & mask) * (b & mask),
+                      p01 = (a & mask) * (b >> 64),
+                      p10 = (a >> 64) * (b & mask), p11 = (a >> 64) * (b >> 64);
+    unsigned __int128 mid = (p00 >> 64) + (p01 & mask) + (p10 & mask);
+    low = (p00 & mask) | (mid << 64);
+    high = p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+  };
+  unsigned __int128 h1, l1, h2, l2;
+  product(a, b, h1, l1);
+  product(c, d, h2, l2);
+  return h1 < h2 || (h1 == h2 && l1 <= l2);
+}
+
+// floor(sqrt(N)); sqrtl() has 64 bits of precision only
+template <typename I> I divisor_hull_x0(const I &N) {
+  I x0 = sqrtl(N + 0.5);
+  while ((__int128)x0 * x0 > N)
+    --x0;
+  while ((__int128)(x0 + 1) * (x0 + 1) <= N)
+    ++x0;
+  return x0;
+}
+
+// floor(N^(1/3)); cbrtl() has 64 bits of precision only
+inline long long divisor_hull_cbrt(const long long &N) {
+  long long r = cbrtl(N);
+  while ((__int128)r * r * r > N)
+    --r;
+  while ((__int128)(r + 1) * (r + 1) * (r + 1) <= N)
+    ++r;
+  return r;
+}
+
+// about N^(2/3), where the hull has as many vertices as there are rows left
+template <typename I> I divisor_hull_x1(const I &N) {
+  return cbrtl(N) * cbrtl(N);
+}
+
+// Builds the lowest lattice points strictly above N / x for from <= x < to,
+// 1 <= from < to, into ret (a vector or a visitor, as for convex_hull()),
+// with coordinates of type I: long long up to N < 2^63, __int128 beyond.
+template <typename I = long long, typename Out>
+std::pair<I, I> divisor_hull_range(const typename hull_coordinate<I>::type &N,
+                                   const I &from, const I &to, Out &&ret,
+                                   int threads = 1,
+                                   basic_hull_workspace<I> *work = nullptr) {
+  auto outside = [&](const I &x, const I &y) {
+    return (__int128)x * y > (__int128)N;
+  };
+  // x * x * dy outgrows __int128 once x does not fit in 64 bits
+  auto turned = [&](const I &x, const I &dx, const I &dy) {
+    if (sizeof(I) > 8)
+      return product_le(N, dx, x, x * dy);
+    return (__int128)N * dx <= (__int128)x * x * dy;
+  };
+  return convex_hull_parallel<I>(from, N / from + 1, to, convex_decrease,
+                                 outside, turned, ret, threads, 0, work);
+}
+
+// The sum of N / x over from <= x < to, sqrt(N) < from < to: Pick's theorem
+// edge by edge over divisor_hull_range(), as in S() of DIVCNT1, and the last
+// column by itself.
+inline __int128 divisor_hull_count(const long long &N, const long long &from,
+                                   const long long &to, int threads = 1,
+                                   hull_workspace *work = nullptr) {
+  __int128 ret = 0;
+  std::pair<long long, long long> prev;
+  bool started = false;
+  auto visit = [&](const long long &x, const long long &y) {
+    if (started) {
+      const std::pair<long long, long long> &p1 = prev;
+      const long long g = hull_gcd(x - p1.first, p1.second - y);
+      const __int128 points = (__int128)(x - p1.first) + g + y + p1.second;
+      ret += ((__int128)(y + p1.second) * (x - p1.first) - points) / 2 +
+             p1.second;
+    }
+    prev = std::make_pair(x, y);
+    started = true;
+  };
+  divisor_hull_range(N, from, to, visit, threads, work);
+  return ret + prev.second - 1;
+}
+
+// Builds the hull for N >= 12, from divisor_hull_x0(N) + 1 to
+// divisor_hull_x1(N).
+template <typename I = long long, typename Out>
+std::pair<I, I> divisor_hull(const typename hull_coordinate<I>::type &N,
+                             Out &&ret, int threads = 1,
+                             basic_hull_workspace<I> *work = nullptr) {
+  return divisor_hull_range<I>(N, divisor_hull_x0(N) + 1, divisor_hull_x1(N),
+                               ret, threads, work);
+}
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef DIVISOR_SUM_H
+#define DIVISOR_SUM_H
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "convex_hull.h"
+#include "divisor_hull.h"
+#include "floor_quotient.h"
+#include "hull_file.h"
+
+// The sums of sigma_k(n) over n <= N for k = 0, ..., K (K <= 2), all from one
+// divisor_hull(N).
+//
+// Every point (x, y) with x, y >= 1 and x * y <= N adds x^k to the sum of
+// sigma_k. With s = floor(sqrt(N)) and F(x) = N / x, the points left of s
+// mirror to those below s, so the sum is
+//   s * W_k(s) + sum over x > s of (x^k * F(x) + W_k(F(x))),
+// W_k(y) = 1^k + ... + y^k. Under an edge of the hull F is the floor of a
+// line, and both terms follow from its floor moments below. The hull ends at
+// divisor_hull_x1(N); the columns beyond it are taken a row at a time.
+
+// v / d for v >= 0 divisible by d, in 64 bits where v fits
+inline __int128 floor_exact_div(const __int128 &v, const long long &d) {
+  if ((unsigned __int128)v >> 64 == 0)
+    return (unsigned long long)v / d;
+  return v / d;
+}
+inline long long floor_exact_div(const long long &v, const long long &d) {
+  return v / d;
+}
+
+// 0^e + 1^e + ... + n^e for e <= 3 and n >= -1, exactly
+inline __int128 floor_power_sum(const int &e, const long long &n) {
+  // n * (n + 1) / 2, and one of n, n + 1, 2 * n + 1 divided by 3
+  long long a = n, b = n + 1, c = 2 * n + 1;
+  (a % 2 == 0 ? a : b) /= 2;
+  switch (e) {
+  case 0:
+    return n + 1;
+  case 1:
+    return (__int128)a * b;
+  case 2:
+    (a % 3 == 0 ? a : b % 3 == 0 ? b : c) /= 3;
+    return (__int128)a * b * c;
+  default:
+    return (__int128)a * b * ((__int128)a * b);
+  }
+}
+
+// s[p][q] = sum over t = 0, ..., n of t^p * floor((a * t + b) / c)^q, for
+// p + q <= Q <= 3, exactly
+template <int Q, typename V = __int128> struct floor_moments {
+  V s[Q + 1][Q + 1];
+};
+
+// Whether the floor moments, and what the Euclidean algorithm below meets on
+// the way, fit in 64 bits when t and the floors stay below L: they are below
+// 6 * L^(Q + 1).
+template <int Q> bool floor_moments_fit_64(const long long &L) {
+  return L < (Q <= 2 ? 1 << 20 : 1 << 15);
+}
+
+// The Euclidean algorithm on the floor moments, the way calc() of AFS3 runs
+// it on three of them. a >= c or b >= c splits off the integer part of the
+// line. Otherwise, with m = floor((a * n + b) / c), the floor at t counts the
+// j < m with t > floor((c * j + c - b - 1) / a), so the moments turn into
+// moments of that line over j = 0, ..., m - 1: the power sum of t up to it
+// is a polynomial in it of degree p + 1. V is the type of the moments.
+template <int Q, typename V = __int128>
+floor_moments<Q, V> floor_moment_sum(const long long &a, const long long &b,
+                                     const long long &c, const long long &n) {
+  static const long long binomial[4][4] = {
+      {1}, {1, 1}, {1, 2, 1}, {1, 3, 3, 1}};
+  // (p == 2 ? 6 : p) * (0^p + ... + x^p) = sum of pc[p][e] * x^e
+  static const long long pc[3][4] = {{1, 1}, {0, 1, 1}, {0, 1, 3, 2}};
+  // (j + 1)^q - j^q = sum of dc[q][d] * j^d
+  static const long long dc[4][3] = {{}, {1}, {1, 2}, {1, 3, 3}};
+  floor_moments<Q, V> ret;
+  if (a >= c || b >= c) {
+    const floor_moments<Q, V> r = floor_moment_sum<Q, V>(a % c, b % c, c, n);
+    for (int p = 0; p <= Q; ++p)
+      ret.s[p][0] = r.s[p][0];
+    V alpha[Q + 1], beta[Q + 1];
+    alpha[0] = beta[0] = 1;
+    for (int e = 1; e <= Q; ++e)
+      alpha[e] = alpha[e - 1] * (a / c), beta[e] = beta[e - 1] * (b / c);
+    // (alpha * t + beta + r)^q, expanded
+    for (int p = 0; p < Q; ++p)
+      for (int q = 1; p + q <= Q; ++q) {
+        V v = 0;
+        for (int k = 0; k <= q; ++k)
+          for (int l = 0; l <= q - k; ++l)
+            v += binomial[q][k] * binomial[q - k][l] * alpha[l] *
+                 beta[q - k - l] * r.s[p + l][k];
+        ret.s[p][q] = v;
+      }
+    return ret;
+  }
+  for (int p = 0; p <= Q; ++p)
+    for (int q = 0; p + q <= Q; ++q)
+      ret.s[p][q] = q ? 0 : (V)floor_power_sum(p, n);
+  const long long m = a < 1LL << 31 && n < 1LL << 31
+                          ? (a * n + b) / c
+                          : (long long)(((__int128)a * n + b) / c);
+  if (m == 0)
+    return ret;
+  const floor_moments<Q, V> r =
+      floor_moment_sum<Q, V>(c, c - b - 1, a, m - 1);
+  for (int p = 0; p < Q; ++p) {
+    V power = 1; // m^q
+    for (int q = 1; p + q <= Q; ++q) {
+      power *= m;
+      V v = 0;
+      for (int d = 0; d < q; ++d)
+        for (int e = 0; e <= p + 1; ++e)
+          v += dc[q][d] * pc[p][e] * r.s[d][e];
+      if (p)
+        v = floor_exact_div(v, p == 2 ? 6 : 2);
+      ret.s[p][q] = ret.s[p][0] * power - v;
+    }
+  }
+  return ret;
+}
+
+template <int K, typename T = __int128> struct divisor_sums {
+  T sigma[K + 1]; // sigma[k] = sum of sigma_k(n) over n <= N
+};
+
+// 1^k + 2^k + ... + n^k for k <= 2 in the ring T, which has no division:
+// the factors are divided exactly before they go to T.
+template <typename T> T divisor_power_sum(const int &k, const __int128 &n) {
+  if (k == 0)
+    return T(n);
+  __int128 a = n, b = n + 1, c = 2 * n + 1;
+  (a % 2 == 0 ? a : b) /= 2;
+  if (k == 1)
+    return T(a) * T(b);
+  (a % 3 == 0 ? a : b % 3 == 0 ? b : c) /= 3;
+  return T(a) * T(b) * T(c);
+}
+
+// The sums of sigma_k(n) over n <= N < 2^63 for k <= K in the ring T:
+// __int128 while they fit (sigma_2 up to N near 1e12), unsigned long long
+// modulo 2^64, or a modular<P> (modular.h). Each edge is summed exactly in
+// __int128 before it goes to T. If hull holds divisor_hull(N)
+// (hull_view::holds(N)), the hull is read from it instead of built.
+template <int K, typename T = __int128>
+divisor_sums<K, T> divisor_sum(const long long &N, int threads = 1,
+                               const hull_view *hull = nullptr) {
+  static_assert(K >= 0 && K <= 2, "power sums are there for k <= 2 only");
+  divisor_sums<K, T> ret;
+  for (int k = 0; k <= K; ++k)
+    ret.sigma[k] = 0;
+  if (N < 12) {
+    for (long long d = 1; d <= N; ++d) {
+      T power = 1; // d^k
+      for (int k = 0; k <= K; ++k, power = power * T(d))
+        ret.sigma[k] = ret.sigma[k] + T(N / d) * power;
+    }
+    return ret;
+  }
+  static thread_local hull_workspace work;
+  // columns[k] = sum of x^k * F(x), rows[k] = sum of W_k(F(x)), over x > s
+  T columns[K + 1], rows[K + 1];
+  for (int k = 0; k <= K; ++k)
+    columns[k] = rows[k] = 0;
+  // adds the column x with F(x) = y
+  auto add_column = [&](const __int128 &x, const __int128 &y) {
+    __int128 X = 1;
+    for (int k = 0; k <= K; ++k, X *= x) {
+      columns[k] = columns[k] + T(X * y);
+      rows[k] = rows[k] + divisor_power_sum<T>(k, y);
+    }
+  };
+  std::pair<long long, long long> prev;
+  bool started = false;
+  auto visit = [&](const long long &x, const long long &y) {
+    add_column(x, y - 1);
+    if (started && x - prev.first > 1) {
+      // F(x - t) = y - 1 + floor((dy * t + dx - 1) / dx) for 0 < t < dx
+      const long long dx = x - prev.first, dy = prev.second - y, n = dx - 1;
+      const __int128 Y = y - 1;
+      floor_moments<K + 1> f;
+      if (floor_moments_fit_64<K + 1>(std::max(dx, dy + 1))) {
+        const floor_moments<K + 1, long long> narrow =
+            floor_moment_sum<K + 1, long long>(dy, dx - 1, dx, n);
+        for (int p = 0; p <= K + 1; ++p)
+          for (int q = 0; p + q <= K + 1; ++q)
+            f.s[p][q] = narrow.s[p][q];
+      } else
+        f = floor_moment_sum<K + 1>(dy, dx - 1, dx, n);
+      // A[q] = sum of F^q, B[p] = sum of t^p * F over the edge
+      const __int128 A1 = n * Y + f.s[0][1];
+      columns[0] = columns[0] + T(A1);
+      rows[0] = rows[0] + T(A1);
+      if constexpr (K >= 1) {
+        const __int128 A2 = n * Y * Y + 2 * Y * f.s[0][1] + f.s[0][2],
+                       B1 = Y * floor_power_sum(1, n) + f.s[1][1];
+        columns[1] = columns[1] + T(x * A1 - B1);
+        rows[1] = rows[1] + T(floor_exact_div(A2 + A1, 2));
+        if constexpr (K >= 2) {
+          const __int128 A3 = n * Y * Y * Y + 3 * Y * Y * f.s[0][1] +
+                              3 * Y * f.s[0][2] + f.s[0][3],
+                         B2 = Y * floor_power_sum(2, n) + f.s[2][1];
+          columns[2] = columns[2] + T((__int128)x * x * A1 - 2 * x * B1 + B2);
+          rows[2] = rows[2] + T(floor_exact_div(2 * A3 + 3 * A2 + A1, 6));
+        }
+      }
+    }
+    prev = std::make_pair(x, y);
+    started = true;
+  };
+  const long long s = divisor_hull_x0(N), x1 = divisor_hull_x1(N);
+  if (hull && hull->holds(N)) {
+    assert(hull->front() == std::make_pair(s + 1, N / (s + 1) + 1));
+    hull->for_each(visit);
+  } else
+    divisor_hull(N, visit, threads, &work);
+  assert(prev.first == x1 - 1);
+
+  // the columns from x1 on, a row y at a time
+  T left[K + 1];
+  for (int k = 0; k <= K; ++k)
+    left[k] = divisor_power_sum<T>(k, x1 - 1);
+  const floor_quotients<> quotient(N, N / x1);
+  for (long long y = 1; y <= N / x1; ++y) {
+    const long long right = quotient(y);
+    T Y = 1; // y^k
+    for (int k = 0; k <= K; ++k, Y = Y * T(y)) {
+      columns[k] = columns[k] + divisor_power_sum<T>(k, right) - left[k];
+      rows[k] = rows[k] + Y * T(right - x1 + 1);
+    }
+  }
+  for (int k = 0; k <= K; ++k)
+    ret.sigma[k] = T(s) * divisor_power_sum<T>(k, s) + columns[k] + rows[k];
+  return ret;
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef DIVISOR_WINDOW_H
+#define DIVISOR_WINDOW_H
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include "divisor_hull.h"
+#include "divisor_sum.h"
+
+// D(N) for every N in a window [A, B]: D(A) from the hull, then D(N) =
+// D(N - 1) + d(N), with the number of divisors d(N) of the window sieved
+// segment by segment.
+//
+// A segment of the window holds what is left of each N and its divisor count
+// so far. Every prime p <= L divides out of its multiples in it, with its
+// exponent e multiplying the count by e + 1. Primes below the length of a
+// segment are started afresh in each; the larger ones hit few segments and
+// wait in the bucket of the next segment they hit, so that every segment
+// costs only what it sieves.
+//
+// The limit L lies between cbrt(B) and sqrt(B). What is left of N then has
+// no prime factor up to L and at most two beyond: below (L + 1)^2 it is 1 or
+// a prime, else a square p^2 or, by Miller-Rabin, a prime or a product p * q.
+// Each test costs a fraction of a microsecond, against a few nanoseconds per
+// number to sieve the primes up to L, so L is 64 times the length of the
+// window, within cbrt(B) and sqrt(B), and long windows test next to nothing.
+
+// Hands visit(p) every prime p <= n in order, by the sieve of Eratosthenes
+// over the odd numbers, segment by segment: it keeps only the primes up to
+// sqrt(n) and one segment.
+template <typename Visit>
+void divisor_window_primes(const long long &n, Visit &&visit) {
+  if (n < 2)
+    return;
+  visit(2u);
+  // the odd primes up to sqrt(n), each at its next odd multiple to strike
+  const long long root = divisor_hull_x0(n);
+  std::vector<std::pair<long long, long long>> base;
+  std::vector<char> composite(root / 2 + 1);
+  for (long long i = 3; i <= root; i += 2) {
+    if (composite[i / 2])
+      continue;
+    base.emplace_back(i, i * i);
+    for (long long j = i * i; j <= root; j += 2 * i)
+      composite[j / 2] = 1;
+  }
+  // segments of length odd numbers lo, lo + 2, ... below hi
+  const long long length = 1 << 15;
+  std::vector<char> sieve(length);
+  for (long long lo = 3; lo <= n; lo += 2 * length) {
+    const long long hi = std::min(lo + 2 * length, n + 1);
+    std::fill(sieve.begin(), sieve.end(), 0);
+    for (auto &q : base) {
+      if (q.first * q.first >= hi)
+        break;
+      for (; q.second < hi; q.second += 2 * q.first)
+        sieve[(q.second - lo) / 2] = 1;
+    }
+    for (long long i = lo; i < hi; i += 2)
+      if (!sieve[(i - lo) / 2])
+        visit((unsigned)i);
+  }
+}
+
+// The inverse of the odd n modulo 2^64, by Newton's iteration: n is its own
+// inverse in the lowest 3 bits, and each step doubles the bits that are.
+inline unsigned long long divisor_window_inverse(const unsigned long long &n) {
+  unsigned long long inverse = n;
+  for (int i = 0; i < 5; ++i)
+    inverse *= 2 - n * inverse;
+  return inverse;
+}
+
+// Whether the odd n > 1, n < 2^63, is prime, by the strong probable prime
+// test to the seven bases that decide it below 2^64, in Montgomery form.
+inline bool divisor_window_prime(const unsigned long long &n) {
+  const unsigned long long inverse = divisor_window_inverse(n);
+  // t / 2^64 modulo n for t < n * 2^64; with n < 2^63 nothing overflows
+  auto reduce = [&](const unsigned __int128 &t) {
+    const unsigned long long m = (unsigned long long)t * -inverse;
+    const unsigned long long u = (t + (unsigned __int128)m * n) >> 64;
+    return u >= n ? u - n : u;
+  };
+  auto multiply = [&](unsigned long long a, unsigned long long b) {
+    return reduce((unsigned __int128)a * b);
+  };
+  const unsigned long long square = -(unsigned __int128)n % n, // 2^128 mod n
+      one = reduce(square), minus_one = n - one;
+  const int s = __builtin_ctzll(n - 1);
+  const unsigned long long d = (n - 1) >> s;
+  for (const unsigned long long &a :
+       {2ULL, 325ULL, 9375ULL, 28178ULL, 450775ULL, 9780504ULL,
+        1795265022ULL}) {
+    if (a % n == 0)
+      continue;
+    unsigned long long base = multiply(a % n, square), x = one;
+    for (unsigned long long e = d; e; e >>= 1) {
+      if (e & 1)
+        x = multiply(x, base);
+      base = multiply(base, base);
+    }
+    if (x == one || x == minus_one)
+      continue;
+    int i = 1;
+    for (; i < s && x != minus_one; ++i)
+      x = multiply(x, x);
+    if (x != minus_one)
+      return false;
+  }
+  return true;
+}
+
+// Hands visit(N, d(N)) every N from A to B in order, 1 <= A <= B < 2^63.
+// Places in the window are kept as offsets from A, which cannot overflow.
+template <typename Visit>
+void divisor_window_counts(const long long &A, const long long &B,
+                           Visit &&visit) {
+  assert(1 <= A && A <= B);
+  // the window in segments of length
+  const long long length = 1 << 15, width = B - A + 1;
+  const long long segments = (width - 1) / length + 1;
+  const long long L = std::min(divisor_hull_x0(B),
+                               std::max(divisor_hull_cbrt(B), 64 * width));
+  const unsigned long long below = (unsigned long long)(L + 1) * (L + 1);
+  // the primes from length to L, each at the offset of its next multiple in
+  // the window; the odd ones below divide by their inverse modulo 2^64: v is
+  // a multiple of p if and only if v * inverse <= (2^64 - 1) / p, and then
+  // v / p = v * inverse, with no division
+  struct small_prime {
+    unsigned p;
+    unsigned long long inverse, limit;
+  };
+  std::vector<small_prime> small;
+  std::vector<std::vector<std::pair<unsigned, long long>>> buckets(segments);
+  divisor_window_primes(L, [&](const unsigned &p) {
+    if (p >= length) {
+      const long long m = (p - A % p) % p;
+      if (m < width)
+        buckets[m / length].emplace_back(p, m);
+    } else if (p != 2) {
+      small.push_back({p, divisor_window_inverse(p), ~0ULL / p});
+    }
+  });
+
+  std::vector<unsigned long long> left(length);
+  std::vector<unsigned> count(length);
+  for (long long k = 0; k < segments; ++k) {
+    const long long lo = k * length, hi = std::min(lo + length, width);
+    const long long first = A + lo, last = A + (hi - 1);
+    const int n = hi - lo;
+    for (int i = 0; i < n; ++i)
+      left[i] = first + i, count[i] = 1;
+    for (int i = first & 1; i < n; i += 2) {
+      const int e = __builtin_ctzll(left[i]);
+      left[i] >>= e;
+      count[i] *= e + 1;
+    }
+    for (const small_prime &q : small) {
+      if ((long long)q.p * q.p > last)
+        break;
+      for (long long i = (q.p - first % q.p) % q.p; i < n; i += q.p) {
+        unsigned long long v = left[i] * q.inverse;
+        int e = 1;
+        for (unsigned long long w; (w = v * q.inverse) <= q.limit; v = w)
+          ++e;
+        left[i] = v;
+        count[i] *= e + 1;
+      }
+    }
+    for (const auto &bucket : buckets[k]) {
+      const unsigned p = bucket.first;
+      unsigned long long &v = left[bucket.second - lo];
+      int e = 0;
+      do
+        v /= p, ++e;
+      while (v % p == 0);
+      count[bucket.second - lo] *= e + 1;
+      const long long next = bucket.second + p;
+      if (next < width)
+        buckets[next / length].emplace_back(p, next);
+    }
+    std::vector<std::pair<unsigned, long long>>().swap(buckets[k]);
+    for (int i = 0; i < n; ++i) {
+      const unsigned long long v = left[i];
+      unsigned d = count[i];
+      if (v >= below) {
+        const unsigned long long r = divisor_hull_x0((long long)v);
+        d *= r * r == v ? 3 : divisor_window_prime(v) ? 2 : 4;
+      } else if (v > 1) {
+        d *= 2;
+      }
+      visit(first + i, d);
+    }
+  }
+}
+
+// Hands visit(N, D(N)) every N from A to B in order, 1 <= A <= B < 2^63, with
+// D(N) as __int128. The hull of A is built on threads threads. Near 1e15 a
+// long window takes about 40 ns per N; short windows near 1e18 take about
+// a quarter of a microsecond per N, after a hull of about half a second.
+template <typename Visit>
+void divisor_count_window(const long long &A, const long long &B,
+                          Visit &&visit, int threads = 1) {
+  assert(1 <= A && A <= B);
+  __int128 D = divisor_sum<0>(A, threads).sigma[0];
+  visit(A, D);
+  if (A < B)
+    divisor_window_counts(A + 1, B, [&](long long N, unsigned d) {
+      D += d;
+      visit(N, D);
+    });
+}
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef FAST_IO_H
+#define FAST_IO_H
+
+#include <cstring>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Reads the whole input at once: mapped if it is a regular file, otherwise
+// with one read() after another into a growing buffer.
+struct fast_input {
+  const char *pos = nullptr, *end = nullptr;
+
+  explicit fast_input(int fd = 0) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+      off_t offset = lseek(fd, 0, SEEK_CUR);
+      void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        mapped = p;
+        mapped_size = st.st_size;
+        pos = (const char *)p + (offset > 0 ? offset : 0);
+        end = (const char *)p + st.st_size;
+        return;
+      }
+    }
+    size_t size = 0;
+    buffer.resize(1 << 16);
+    for (ssize_t got; (got = ::read(fd, buffer.data() + size,
+                                    buffer.size() - size)) > 0;) {
+      size += got;
+      if (size == buffer.size())
+        buffer.resize(buffer.size() * 2);
+    }
+    pos = buffer.data();
+    end = buffer.data() + size;
+  }
+
+  ~fast_input() {
+    if (mapped)
+      munmap(mapped, mapped_size);
+  }
+
+  fast_input(const fast_input &) = delete;
+  fast_input &operator=(const fast_input &) = delete;
+
+  // Parses the next integer, skipping whatever precedes it. Returns false at
+  // the end of the input. A negative number is built downwards, so that the
+  // least value of T does not overflow on the way.
+  template <typename T> bool read(T &x) {
+    while (pos != end && (*pos < '0' || *pos > '9') && *pos != '-')
+      ++pos;
+    if (pos == end)
+      return false;
+    const bool negative = *pos == '-';
+    if (negative)
+      ++pos;
+    x = 0;
+    while (pos != end && *pos >= '0' && *pos <= '9') {
+      const int digit = *pos++ - '0';
+      x = negative ? x * 10 - digit : x * 10 + digit;
+    }
+    return true;
+  }
+
+private:
+  void *mapped = nullptr;
+  size_t mapped_size = 0;
+  std::vector<char> buffer;
+};
+
+// Collects the whole output in memory and writes it in one go when flushed
+// or destroyed. 128-bit numbers are cut into 64-bit chunks of 19 digits, and
+// each chunk is formatted two digits at a time.
+struct fast_output {
+  explicit fast_output(int fd = 1) : fd(fd) {}
+  ~fast_output() { flush(); }
+
+  fast_output(const fast_output &) = delete;
+  fast_output &operator=(const fast_output &) = delete;
+
+  void put(char c) { buffer.push_back(c); }
+
+  void write(unsigned long long x) {
+    char digits[20];
+    char *begin = format(digits + 20, x);
+    buffer.insert(buffer.end(), begin, digits + 20);
+  }
+
+  void write(long long x) {
+    if (x < 0) {
+      put('-');
+      write(0ULL - (unsigned long long)x);
+    } else
+      write((unsigned long long)x);
+  }
+
+  void write(unsigned __int128 x) {
+    const unsigned long long chunk = 10000000000000000000ULL; // 10^19
+    if (x < chunk) {
+      write((unsigned long long)x);
+      return;
+    }
+    unsigned __int128 high = x / chunk;
+    if (high < chunk)
+      write((unsigned long long)high);
+    else {
+      write((unsigned long long)(high / chunk));
+      write_chunk(high % chunk);
+    }
+    write_chunk(x % chunk);
+  }
+
+  void write(__int128 x) {
+    if (x < 0) {
+      put('-');
+      write((unsigned __int128)0 - (unsigned __int128)x);
+    } else
+      write((unsigned __int128)x);
+  }
+
+  void flush() {
+    size_t done = 0;
+    for (ssize_t wrote; done < buffer.size() &&
+                        (wrote = ::write(fd, buffer.data() + done,
+                                         buffer.size() - done)) > 0;)
+      done += wrote;
+    buffer.clear();
+  }
+
+private:
+  int fd;
+  std::vector<char> buffer;
+
+  // Writes x right-aligned in front of end and returns the first digit.
+  static char *format(char *end, unsigned long long x) {
+    static const char pairs[] = "00010203040506070809"
+                                "10111213141516171819"
+                                "20212223242526272829"
+                                "30313233343536373839"
+                                "40414243444546474849"
+                                "50515253545556575859"
+                                "60616263646566676869"
+                                "70717273747576777879"
+                                "80818283848586878889"
+                                "90919293949596979899";
+    while (x >= 100) {
+      end -= 2;
+      memcpy(end, pairs + x % 100 * 2, 2);
+      x /= 100;
+    }
+    if (x >= 10) {
+      end -= 2;
+      memcpy(end, pairs + x * 2, 2);
+    } else
+      *--end = '0' + x;
+    return end;
+  }
+
+  // the lower chunk of a number, padded with zeros to 19 digits
+  void write_chunk(unsigned long long x) {
+    char digits[19];
+    char *begin = format(digits + 19, x);
+    memset(digits, '0', begin - digits);
+    buffer.insert(buffer.end(), digits, digits + 19);
+  }
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef FLOOR_QUOTIENT_H
+#define FLOOR_QUOTIENT_H
+
+#include <atomic>
+#include <mutex>
+
+// N / t for the small t the solutions take one at a time past the hull (up to
+// about N^(1/3)), without a hardware division: t does not depend on N, so its
+// reciprocal floor((2^64 - 1) / t) is computed once per process and serves
+// every query after. For N < 2^63 the high half of N times it is N / t or one
+// less, which one comparison of the remainder settles.
+//
+// Stepping N / t from t to t + 1 with additions alone only pays off once the
+// quotients change by little from one t to the next, i.e. beyond N^(1/3),
+// where these loops end.
+
+// The reciprocals cover t below this, up to N^(1/3) for any N < 2^63.
+const long long floor_reciprocal_capacity = 1 << 22;
+
+// floor((2^64 - 1) / t) for 1 <= t < size <= floor_reciprocal_capacity,
+// shared by all threads. The table grows on demand under a lock; what is
+// filled never changes again, so it is read without one.
+inline const unsigned long long *floor_reciprocals(const long long &size) {
+  static unsigned long long *const table =
+      new unsigned long long[floor_reciprocal_capacity];
+  static std::atomic<long long> filled(1);
+  static std::mutex grow;
+  if (filled < size) {
+    std::lock_guard<std::mutex> lock(grow);
+    for (long long t = filled; t < size; ++t)
+      table[t] = ~0ULL / t;
+    if (filled < size)
+      filled = size;
+  }
+  return table;
+}
+
+// quotient(t) = N / t for 1 <= t, with the reciprocals of t <= t_max made
+// ready by the constructor. Beyond those, and for coordinates wider than
+// 64 bits, it divides.
+template <typename I = long long> struct floor_quotients {
+  floor_quotients(const I &N, const long long &t_max) : N(N) {
+    if (sizeof(I) == 8 && N >= 0)
+      size = t_max < floor_reciprocal_capacity ? t_max + 1
+                                               : floor_reciprocal_capacity;
+    if (size > 1)
+      reciprocal = floor_reciprocals(size);
+  }
+
+  I operator()(const long long &t) const {
+    if (t >= size)
+      return N / t;
+    unsigned long long q =
+        (unsigned __int128)(unsigned long long)N * reciprocal[t] >> 64;
+    if ((unsigned long long)N - q * t >= (unsigned long long)t)
+      ++q;
+    return q;
+  }
+
+private:
+  I N;
+  long long size = 0;
+  const unsigned long long *reciprocal = nullptr;
+};
+
+#endif
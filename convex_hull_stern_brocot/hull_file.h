@@ -0,0 +1,184 @@
+#ifndef HULL_FILE_H
+#define HULL_FILE_H
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "convex_hull.h"
+
+// A compact binary form of a hull with long long coordinates, so that the
+// hulls of N that come up again need not be rebuilt. After the magic "HUL2"
+// come the N the hull was built for (0 if none), the number of vertices, the
+// length of the edges in bytes and the first vertex, then every edge as its
+// direction (dx, dy) reduced by their gcd, followed by the gcd, i.e. how many
+// lattice steps the edge takes. All are LEB128 varints, the signed ones
+// zigzag encoded. The edges of N / x are short, so most of them take 3 or 4
+// bytes instead of the 16 of a vertex in a vector.
+
+inline void hull_file_put(std::vector<unsigned char> &out,
+                          unsigned long long v) {
+  for (; v >= 0x80; v >>= 7)
+    out.push_back((unsigned char)(v | 0x80));
+  out.push_back((unsigned char)v);
+}
+
+inline unsigned long long hull_file_zigzag(long long v) {
+  return ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63);
+}
+
+inline long long hull_file_unzigzag(unsigned long long v) {
+  return (long long)(v >> 1) ^ -(long long)(v & 1);
+}
+
+// A visitor that encodes the vertices it is given: pass it as ret to
+// convex_hull() (or divisor_hull()), then save() it or take its bytes(). N
+// goes into the header, so that a view of the file can tell whose hull it
+// holds.
+struct hull_encoder {
+  explicit hull_encoder(const long long &N = 0) : N(N) {}
+
+  void operator()(const long long &x, const long long &y) {
+    if (vertices++ == 0) {
+      first = std::make_pair(x, y);
+    } else {
+      const long long dx = x - last.first, dy = y - last.second;
+      const long long a = hull_gcd(dx, dy < 0 ? -dy : dy);
+      hull_file_put(edges, dx / a);
+      hull_file_put(edges, hull_file_zigzag(dy / a));
+      hull_file_put(edges, a);
+    }
+    last = std::make_pair(x, y);
+  }
+
+  std::vector<unsigned char> bytes() const {
+    std::vector<unsigned char> out = {'H', 'U', 'L', '2'};
+    hull_file_put(out, N);
+    hull_file_put(out, vertices);
+    hull_file_put(out, edges.size());
+    hull_file_put(out, hull_file_zigzag(first.first));
+    hull_file_put(out, hull_file_zigzag(first.second));
+    out.insert(out.end(), edges.begin(), edges.end());
+    return out;
+  }
+
+  // Returns false if the file could not be written.
+  bool save(const char *path) const {
+    const std::vector<unsigned char> out = bytes();
+    FILE *file = fopen(path, "wb");
+    if (!file)
+      return false;
+    const bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+    return fclose(file) == 0 && written;
+  }
+
+private:
+  long long N, vertices = 0;
+  std::pair<long long, long long> first, last;
+  std::vector<unsigned char> edges;
+};
+
+// A read-only view of an encoded hull, mapped from a file or over bytes in
+// memory. for_each() decodes the vertices as it hands them to visit(x, y),
+// so the hull is never stored. A file that cannot be mapped, or that is not a
+// hull, gives a view that is not valid() and holds no vertices. Readers of
+// the hull of N check holds(N) and build the hull themselves otherwise, so
+// that the file of another N, or of another format, is never summed.
+struct hull_view {
+  explicit hull_view(const char *path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        mapped = p;
+        mapped_size = st.st_size;
+        read_header((const unsigned char *)p, st.st_size);
+      }
+    }
+    close(fd);
+  }
+
+  hull_view(const unsigned char *data, size_t size) { read_header(data, size); }
+
+  ~hull_view() {
+    if (mapped)
+      munmap(mapped, mapped_size);
+  }
+
+  hull_view(const hull_view &) = delete;
+  hull_view &operator=(const hull_view &) = delete;
+
+  bool valid() const { return vertices > 0; }
+  // whether the view holds the hull encoded by hull_encoder(N)
+  bool holds(const __int128 &N) const { return valid() && N == curve; }
+  long long size() const { return vertices; }
+  const std::pair<long long, long long> &front() const { return first; }
+
+  template <typename Visit> void for_each(Visit &&visit) const {
+    if (!valid())
+      return;
+    const unsigned char *pos = edges;
+    long long x = first.first, y = first.second;
+    visit(x, y);
+    for (long long i = 1; i < vertices; ++i) {
+      const long long dx = get(pos), dy = hull_file_unzigzag(get(pos));
+      const long long steps = get(pos);
+      x += dx * steps, y += dy * steps;
+      visit(x, y);
+    }
+  }
+
+private:
+  void *mapped = nullptr;
+  size_t mapped_size = 0;
+  long long curve = 0, vertices = 0;
+  std::pair<long long, long long> first;
+  const unsigned char *edges = nullptr, *end = nullptr;
+
+  // The next varint, never reading past the end of the data.
+  unsigned long long get(const unsigned char *&pos) const {
+    unsigned long long v = 0;
+    for (int shift = 0; pos != end && shift < 64; shift += 7) {
+      const unsigned char c = *pos++;
+      v |= (unsigned long long)(c & 0x7f) << shift;
+      if (c < 0x80)
+        break;
+    }
+    return v;
+  }
+
+  // Checks the magic, that the header ends within the data and the length
+  // of the edges against what is left of it, so that a truncated file is not
+  // valid.
+  void read_header(const unsigned char *data, size_t size) {
+    if (size < 4 || memcmp(data, "HUL2", 4) != 0)
+      return;
+    const unsigned char *pos = data + 4;
+    end = data + size;
+    auto next = [&](unsigned long long &v) {
+      if (pos == end)
+        return false;
+      v = get(pos);
+      return pos[-1] < 0x80;
+    };
+    unsigned long long N, n, length, x, y;
+    if (!next(N) || !next(n) || !next(length) || !next(x) || !next(y) ||
+        n == 0 || (unsigned long long)(end - pos) != length)
+      return;
+    curve = N;
+    first = std::make_pair(hull_file_unzigzag(x), hull_file_unzigzag(y));
+    edges = pos;
+    vertices = n;
+  }
+};
+
+#endif
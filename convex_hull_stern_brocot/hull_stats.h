@@ -0,0 +1,111 @@
+#ifndef HULL_STATS_H
+#define HULL_STATS_H
+
+// Counters on the hot paths of the hull engine and of S(), compiled in only
+// with -DHULL_STATS. Without it HULL_STAT(...) expands to nothing, so the
+// counters cost nothing at all.
+//
+// Each hull (or S() call) counts into a local hull_stats, which adds itself
+// to totals over all threads when it goes out of scope, the way calc() counts
+// its levels in AFS3. hull_stats_print() reports the totals.
+
+#ifdef HULL_STATS
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#define HULL_STAT(...) __VA_ARGS__
+
+enum hull_stat {
+  stat_descent,   // mediants probed while descending the Stern-Brocot tree
+  stat_walk,      // points probed along an edge
+  stat_backtrack, // directions probed while backtracking
+  stat_start,     // steps raising the start onto the region (convex)
+  stat_cut,       // calls of cut, i.e. of df, turned or the inside fallback
+  stat_vertices,  // vertices emitted
+  stat_depth,     // maximum stack depth
+  stat_ret_bytes, // peak capacity of a vector ret, in bytes
+  stat_hull_ns,   // time building the hull, visitor included
+  stat_visit_ns,  // time in the visitor of S()
+  stat_sum_ns,    // time summing in S() outside the hull
+  stat_count
+};
+
+inline std::atomic<long long> *hull_stats_totals() {
+  static std::atomic<long long> totals[stat_count];
+  return totals;
+}
+
+struct hull_stats {
+  long long s[stat_count] = {};
+
+  hull_stats() = default;
+  hull_stats(const hull_stats &) = delete;
+  hull_stats &operator=(const hull_stats &) = delete;
+
+  ~hull_stats() {
+    std::atomic<long long> *totals = hull_stats_totals();
+    for (int i = 0; i < stat_count; ++i) {
+      if (i == stat_depth || i == stat_ret_bytes) {
+        long long seen = totals[i].load();
+        while (seen < s[i] && !totals[i].compare_exchange_weak(seen, s[i])) {
+        }
+      } else
+        totals[i] += s[i];
+    }
+  }
+
+  void depth(const size_t &size) {
+    s[stat_depth] = std::max(s[stat_depth], (long long)size);
+  }
+
+  template <typename I> void emitted(const std::vector<std::pair<I, I>> &ret) {
+    ++s[stat_vertices];
+    s[stat_ret_bytes] = std::max(
+        s[stat_ret_bytes], (long long)(ret.capacity() * sizeof(ret[0])));
+  }
+  template <typename Visit> void emitted(const Visit &) {
+    ++s[stat_vertices];
+  }
+};
+
+// Adds the time until it goes out of scope to the counter.
+struct hull_timer {
+  long long &ns;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  explicit hull_timer(long long &ns) : ns(ns) {}
+  ~hull_timer() {
+    ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count();
+  }
+};
+
+inline void hull_stats_print(FILE *out) {
+  const std::atomic<long long> *t = hull_stats_totals();
+  fprintf(out,
+          "hull: %lld descent probes, %lld walk probes, "
+          "%lld backtrack probes, %lld start steps, %lld cut calls\n"
+          "hull: %lld vertices, stack depth up to %lld, vector ret up to "
+          "%lld bytes\n"
+          "time: %.3f ms building hulls, %.3f ms summing\n",
+          t[stat_descent].load(), t[stat_walk].load(),
+          t[stat_backtrack].load(), t[stat_start].load(), t[stat_cut].load(),
+          t[stat_vertices].load(), t[stat_depth].load(),
+          t[stat_ret_bytes].load(),
+          (t[stat_hull_ns].load() - t[stat_visit_ns].load()) * 1e-6,
+          (t[stat_visit_ns].load() + t[stat_sum_ns].load()) * 1e-6);
+}
+
+#else
+
+#define HULL_STAT(...)
+
+#endif
+
+#endif
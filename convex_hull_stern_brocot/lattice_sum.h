@@ -0,0 +1,233 @@
+#ifndef LATTICE_SUM_H
+#define LATTICE_SUM_H
+
+#include <cassert>
+#include <utility>
+
+#include "convex_hull.h"
+
+// Sums of x^i * y^j over the lattice points under a monotone f, for
+// 0 <= i, j <= D, in O(hull size * log * D^3) ring operations.
+//
+// Between two vertices of the hull the top point of each column is the
+// floor of a line, so every edge is a polynomial floor sum, which the
+// universal Euclidean algorithm below evaluates. It walks the line as a word
+// of U (the line passes a row) and R (the line passes a column) steps and
+// only multiplies such words, so T needs nothing but +, - and * (it may be
+// __int128, or modular<P> from modular.h). Instead of powers of y,
+// the words carry W_j(y) = 1^j + 2^j + ... + y^j, which is what summing y^j
+// over a column needs, and which shifts with binomials alone:
+// W_j(Y + y) = W_j(Y) + sum_k C(j, k) Y^(j - k) W_k(y).
+
+template <int D> struct lattice_binomials {
+  long long c[D + 1][D + 1];
+  lattice_binomials() {
+    for (int n = 0; n <= D; ++n) {
+      c[n][0] = c[n][n] = 1;
+      for (int k = 1; k < n; ++k)
+        c[n][k] = c[n - 1][k - 1] + c[n - 1][k];
+    }
+  }
+  static const lattice_binomials &get() {
+    static const lattice_binomials table;
+    return table;
+  }
+};
+
+// A word of U and R steps. Its R steps are numbered x = 1, 2, ... and the
+// U steps before each of them give its y.
+template <int D, typename T> struct lattice_word {
+  long long dx = 0, dy = 0; // R and U steps
+  T p[D + 1];               // sum over R steps of x^i
+  T w[D + 1];               // W_j(dy)
+  T s[D + 1][D + 1];        // sum over R steps of x^i * W_j(y)
+
+  lattice_word() {
+    for (int i = 0; i <= D; ++i) {
+      p[i] = w[i] = 0;
+      for (int j = 0; j <= D; ++j)
+        s[i][j] = 0;
+    }
+  }
+
+  static lattice_word up() {
+    lattice_word ret;
+    ret.dy = 1;
+    for (int j = 0; j <= D; ++j)
+      ret.w[j] = 1;
+    return ret;
+  }
+
+  static lattice_word right() {
+    lattice_word ret;
+    ret.dx = 1;
+    for (int i = 0; i <= D; ++i)
+      ret.p[i] = 1;
+    return ret;
+  }
+
+  // this word followed by b
+  lattice_word operator*(const lattice_word &b) const {
+    const auto &c = lattice_binomials<D>::get().c;
+    T X[D + 1], Y[D + 1];
+    X[0] = Y[0] = 1;
+    for (int e = 1; e <= D; ++e) {
+      X[e] = X[e - 1] * T(dx);
+      Y[e] = Y[e - 1] * T(dy);
+    }
+    lattice_word ret;
+    ret.dx = dx + b.dx;
+    ret.dy = dy + b.dy;
+    // q[a][j]: sum over the R steps of b of x_b^a * W_j(dy + y_b)
+    T q[D + 1][D + 1];
+    for (int a = 0; a <= D; ++a)
+      for (int j = 0; j <= D; ++j) {
+        T v = w[j] * b.p[a];
+        for (int k = 0; k <= j; ++k)
+          v = v + T(c[j][k]) * Y[j - k] * b.s[a][k];
+        q[a][j] = v;
+      }
+    for (int i = 0; i <= D; ++i) {
+      T v = p[i];
+      for (int a = 0; a <= i; ++a)
+        v = v + T(c[i][a]) * X[i - a] * b.p[a];
+      ret.p[i] = v;
+      for (int j = 0; j <= D; ++j) {
+        T t = s[i][j];
+        for (int a = 0; a <= i; ++a)
+          t = t + T(c[i][a]) * X[i - a] * q[a][j];
+        ret.s[i][j] = t;
+      }
+    }
+    for (int j = 0; j <= D; ++j) {
+      T v = w[j];
+      for (int k = 0; k <= j; ++k)
+        v = v + T(c[j][k]) * Y[j - k] * b.w[k];
+      ret.w[j] = v;
+    }
+    return ret;
+  }
+};
+
+template <int D, typename T>
+lattice_word<D, T> lattice_power(lattice_word<D, T> base, long long e) {
+  lattice_word<D, T> ret;
+  for (; e; e >>= 1, base = base * base)
+    if (e & 1)
+      ret = ret * base;
+  return ret;
+}
+
+// The word of y = floor((a * x + b) / c) for x = 1, ..., n, where
+// 0 <= b < c, with u and r standing for U and R.
+template <int D, typename T>
+lattice_word<D, T> lattice_euclid(long long a, long long b, long long c,
+                                  long long n, const lattice_word<D, T> &u,
+                                  const lattice_word<D, T> &r) {
+  if (!n)
+    return lattice_word<D, T>();
+  if (a >= c)
+    return lattice_euclid(a % c, b, c, n, u, lattice_power(u, a / c) * r);
+  long long m = ((__int128)a * n + b) / c;
+  if (!m)
+    return lattice_power(r, n);
+  long long rest = n - ((__int128)c * m - b - 1) / a;
+  return lattice_power(r, (c - b - 1) / a) * u *
+         lattice_euclid(c, (c - b - 1) % a, a, m - 1, r, u) *
+         lattice_power(r, rest);
+}
+
+// sum over x = 1, ..., n of x^i * W_j(floor((a * x + b) / c)), for a, b >= 0
+template <int D, typename T>
+lattice_word<D, T> lattice_floor_sum(long long a, long long b, long long c,
+                                     long long n) {
+  const lattice_word<D, T> u = lattice_word<D, T>::up(),
+                           r = lattice_word<D, T>::right();
+  return lattice_power(u, b / c) * lattice_euclid(a, b % c, c, n, u, r);
+}
+
+template <int D, typename T = __int128_t> struct lattice_sums {
+  // s[i][j] = sum of x^i * y^j over the points counted so far
+  T s[D + 1][D + 1];
+
+  lattice_sums() {
+    for (int i = 0; i <= D; ++i)
+      for (int j = 0; j <= D; ++j)
+        s[i][j] = 0;
+  }
+
+  // Adds the columns strictly between x0 and x0 + dx, or x0 - dx if
+  // backwards, of an edge whose top point at distance t from x0 is
+  // floor((y0 * dx + dy * t + delta) / dx), with dy >= 0.
+  void add_edge(const long long &x0, const long long &y0, const long long &dx,
+                const long long &dy, const bool &backwards,
+                const long long &delta) {
+    if (dx <= 1)
+      return;
+    const auto &c = lattice_binomials<D>::get().c;
+    lattice_word<D, T> word =
+        lattice_floor_sum<D, T>(dy, y0 * dx + delta, dx, dx - 1);
+    // x = x0 + t or x0 - t
+    const T sign = backwards ? T(-1) : T(1);
+    T X[D + 1];
+    X[0] = 1;
+    for (int e = 1; e <= D; ++e)
+      X[e] = X[e - 1] * T(x0);
+    for (int i = 0; i <= D; ++i) {
+      T power = 1; // sign^p
+      for (int p = 0; p <= i; ++p, power = power * sign)
+        for (int j = 0; j <= D; ++j)
+          s[i][j] = s[i][j] + T(c[i][p]) * X[i - p] * power * word.s[p][j];
+    }
+  }
+
+  // Adds the column x whose top point is y.
+  void add_column(const long long &x, const long long &y) {
+    if (y <= 0)
+      return;
+    lattice_word<D, T> word = lattice_floor_sum<D, T>(0, y, 1, 1);
+    T X = 1;
+    for (int i = 0; i <= D; ++i, X = X * T(x))
+      for (int j = 0; j <= D; ++j)
+        s[i][j] = s[i][j] + X * word.s[0][j];
+  }
+};
+
+// The sums of x^i * y^j over the lattice points (x, y) with x1 <= x < x2 and
+// 1 <= y <= F(x), where F(x) is the top point of column x under f: the
+// highest point passing inside for concave shapes, the one below the lowest
+// point passing inside (i.e. outside) for convex shapes. The arguments are
+// the ones of the shape-tagged convex_hull(), with the same assumptions
+// (f positive on [x1, x2)), and (x1, y1) has to be the extreme point of
+// column x1.
+template <int D, typename T = __int128_t, typename Inside, typename Turned>
+lattice_sums<D, T> lattice_sum(const long long &x1, const long long &y1,
+                               const long long &x2, const hull_shape &shape,
+                               const Inside &inside, const Turned &turned) {
+  const bool convex = shape == convex_decrease || shape == convex_increase;
+  const bool decrease = shape == concave_decrease || shape == convex_decrease;
+  // top point of a column below the hull: just below it for convex shapes
+  const long long delta = convex ? -1 : 0;
+  lattice_sums<D, T> ret;
+  std::pair<long long, long long> prev;
+  bool started = false;
+  convex_hull(x1, y1, x2, shape, inside, turned,
+              [&](long long x, long long y) {
+                if (started) {
+                  const long long dx = x - prev.first;
+                  // the top points rise away from the lower end
+                  if (decrease)
+                    ret.add_edge(x, y, dx, prev.second - y, true, delta);
+                  else
+                    ret.add_edge(prev.first, prev.second, dx,
+                                 y - prev.second, false, delta);
+                }
+                ret.add_column(x, y + delta);
+                prev = std::make_pair(x, y);
+                started = true;
+              });
+  assert(started && prev.first == x2 - 1);
+  return ret;
+}
+
+#endif
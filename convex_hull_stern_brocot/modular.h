@@ -0,0 +1,35 @@
+#ifndef MODULAR_H
+#define MODULAR_H
+
+// Integers modulo a P below 2^63: a result ring for S() of DIVCNT1,
+// lattice_sum() and divisor_sum() once the exact sums outgrow __int128.
+// Modulo 2^64 needs no type of its own, unsigned long long wraps around.
+template <unsigned long long P> struct modular {
+  unsigned long long v = 0;
+
+  modular() = default;
+  modular(const __int128 &x) : v((x % (__int128)P + P) % P) {}
+
+  modular operator+(const modular &b) const {
+    modular ret;
+    ret.v = v + b.v >= P ? v + b.v - P : v + b.v;
+    return ret;
+  }
+
+  modular operator-(const modular &b) const {
+    modular ret;
+    ret.v = v >= b.v ? v - b.v : v + P - b.v;
+    return ret;
+  }
+
+  modular operator*(const modular &b) const {
+    modular ret;
+    ret.v = (unsigned __int128)v * b.v % P;
+    return ret;
+  }
+
+  bool operator==(const modular &b) const { return v == b.v; }
+  bool operator!=(const modular &b) const { return v != b.v; }
+};
+
+#endif
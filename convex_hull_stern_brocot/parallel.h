@@ -0,0 +1,91 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// Number of threads to use when the caller leaves it open (threads <= 0).
+inline int hardware_threads() {
+  unsigned threads = std::thread::hardware_concurrency();
+  return threads ? threads : 1;
+}
+
+// Runs work(i) for 0 <= i < count on up to threads threads, the calling one
+// included. The tasks are handed out one at a time in order of i, so put the
+// expensive ones first.
+template <typename Work>
+void parallel_for(const long long &count, int threads, const Work &work) {
+  if (threads <= 0)
+    threads = hardware_threads();
+  if (threads > count)
+    threads = count;
+  if (threads <= 1) {
+    for (long long i = 0; i < count; ++i)
+      work(i);
+    return;
+  }
+  std::atomic<long long> next(0);
+  auto worker = [&]() {
+    for (long long i; (i = next++) < count;)
+      work(i);
+  };
+  std::vector<std::thread> pool;
+  for (int t = 1; t < threads; ++t)
+    pool.emplace_back(worker);
+  worker();
+  for (auto &thread : pool)
+    thread.join();
+}
+
+// The sum of block(from, to) over [0, count) cut into consecutive ranges, on
+// up to threads threads. The partial sums are added in order of the ranges,
+// so for integer sums the result is the serial one for any number of
+// threads. A single thread sums everything as block(0, count).
+template <typename T, typename Block>
+T parallel_sum(const long long &count, int threads, const Block &block) {
+  if (threads <= 0)
+    threads = hardware_threads();
+  if (count <= 0)
+    return T(0);
+  const long long blocks = std::min<long long>(count, 4LL * threads);
+  if (threads <= 1 || blocks <= 1)
+    return block(0, count);
+  std::vector<T> partial(blocks);
+  parallel_for(blocks, threads, [&](long long k) {
+    partial[k] = block((__int128)count * k / blocks,
+                       (__int128)count * (k + 1) / blocks);
+  });
+  T sum = 0;
+  for (const T &part : partial)
+    sum += part;
+  return sum;
+}
+
+// Answers every query with solve(query, threads per query) on up to threads
+// threads and returns the answers in input order. The largest queries are
+// handed out first, so that no long one is left running alone at the end.
+// When there are fewer queries than threads, the spare threads go to the
+// queries themselves.
+template <typename Answer, typename Solve>
+std::vector<Answer> solve_batch(const std::vector<long long> &queries,
+                                int threads, const Solve &solve) {
+  if (threads <= 0)
+    threads = hardware_threads();
+  std::vector<size_t> order(queries.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return queries[a] > queries[b];
+  });
+  const int inner =
+      std::max<long long>(1, threads / std::max<long long>(1, queries.size()));
+  std::vector<Answer> answers(queries.size());
+  parallel_for(order.size(), threads, [&](long long i) {
+    answers[order[i]] = solve(queries[order[i]], inner);
+  });
+  return answers;
+}
+
+#endif